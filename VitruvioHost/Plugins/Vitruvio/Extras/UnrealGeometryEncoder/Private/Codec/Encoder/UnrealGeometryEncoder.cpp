@@ -537,6 +537,10 @@ void UnrealGeometryEncoder::encode(prtx::GenerateContext& context, size_t initia
 
 	IUnrealCallbacks* cb = static_cast<IUnrealCallbacks*>(getCallbacks());
 
+	// The shape tree is only derived once the leaf iterator is created, a canceled initial shape is therefore never generated
+	if (cb->isCanceled())
+		return;
+
 	const bool emitAttrs = getOptions()->getBool(EO_EMIT_ATTRIBUTES);
 
 	prtx::DefaultNamePreparator namePrep;
@@ -550,6 +554,9 @@ void UnrealGeometryEncoder::encode(prtx::GenerateContext& context, size_t initia
 	prtx::LeafIteratorPtr li = prtx::LeafIterator::create(context, initialShapeIndex);
 	for (prtx::ShapePtr shape = li->getNext(); shape; shape = li->getNext())
 	{
+		if (cb->isCanceled())
+			return;
+
 		prtx::ReportsPtr r = reportsCollector->getReports(shape->getID());
 		encPrep->add(context.getCache(), shape, initialShape.getAttributeMap(), r);
 
@@ -585,6 +592,9 @@ void UnrealGeometryEncoder::convertGeometry(const prtx::InitialShape& initialSha
 	prtx::PRTUtils::AttributeMapBuilderPtr instanceMatAmb(prt::AttributeMapBuilder::create());
 	for (const auto& inst : instances)
 	{
+		if (cb->isCanceled())
+			return;
+
 		if (inst.getPrototypeIndex() != -1)
 		{
 			const prtx::MaterialPtrVector& instMaterials = inst.getMaterials();
@@ -622,7 +632,7 @@ void UnrealGeometryEncoder::convertGeometry(const prtx::InitialShape& initialSha
 		}
 	}
 
-	if (geometries.size() > 0)
+	if (geometries.size() > 0 && !cb->isCanceled())
 	{
 		const SerializedGeometry sg = serializeGeometry(geometries, materials);
 		encodeMesh(cb, sg, initialShape.getName(), -1, geometries, materials);
@@ -59,4 +59,13 @@ public:
 	 */
 	virtual void addInstance(int32_t prototypeId, const double* transform, const prt::AttributeMap** instanceMaterial,
 							 size_t numInstanceMaterials) = 0;
+
+	/**
+	 * Polled by the encoder between shapes and instances. If true is returned, the encoder stops generating and encoding the
+	 * remaining initial shapes as soon as possible and the output of the current generate call is incomplete.
+	 * Must stay the last virtual function: encoder binaries built before it was added use the same vtable layout and never call it.
+	 *
+	 * @return true if the current generate call has been canceled
+	 */
+	virtual bool isCanceled() = 0;
 };
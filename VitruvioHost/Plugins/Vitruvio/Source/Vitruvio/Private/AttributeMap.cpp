@@ -15,9 +15,11 @@
 
 #include "AttributeMap.h"
 
-#include "Util/AttributeConversion.h"
-
 TMap<FString, URuleAttribute*> FAttributeMap::ConvertToUnrealAttributeMap(UObject* const Outer)
 {
-	return Vitruvio::ConvertAttributeMap(AttributeMap, RuleInfo, Outer);
+	if (!AttributeMap || !Schema)
+	{
+		return {};
+	}
+	return Schema->CreateAttributes(*AttributeMap, Outer);
 }
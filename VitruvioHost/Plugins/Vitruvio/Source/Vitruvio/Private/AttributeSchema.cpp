@@ -0,0 +1,175 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AttributeSchema.h"
+
+#include "PRTUtils.h"
+#include "Util/AnnotationParsing.h"
+
+namespace
+{
+const FString DEFAULT_STYLE = TEXT("Default");
+
+TSubclassOf<URuleAttribute> GetAttributeClass(const prt::RuleFileInfo::Entry* Entry)
+{
+	switch (Entry->getReturnType())
+	{
+	case prt::AAT_BOOL:
+		return UBoolAttribute::StaticClass();
+	case prt::AAT_INT:
+	case prt::AAT_FLOAT:
+		return UFloatAttribute::StaticClass();
+	case prt::AAT_STR:
+		return UStringAttribute::StaticClass();
+	case prt::AAT_UNKNOWN:
+	case prt::AAT_VOID:
+	case prt::AAT_BOOL_ARRAY:
+	case prt::AAT_FLOAT_ARRAY:
+	case prt::AAT_STR_ARRAY:
+	default:
+		return nullptr;
+	}
+}
+
+void SetValue(URuleAttribute* Attribute, const prt::AttributeMap& Values, const std::wstring& Key)
+{
+	if (UBoolAttribute* BoolAttribute = Cast<UBoolAttribute>(Attribute))
+	{
+		BoolAttribute->Value = Values.getBool(Key.c_str());
+	}
+	else if (UFloatAttribute* FloatAttribute = Cast<UFloatAttribute>(Attribute))
+	{
+		FloatAttribute->Value = Values.getFloat(Key.c_str());
+	}
+	else if (UStringAttribute* StringAttribute = Cast<UStringAttribute>(Attribute))
+	{
+		StringAttribute->Value = WCHAR_TO_TCHAR(Values.getString(Key.c_str()));
+	}
+}
+} // namespace
+
+namespace Vitruvio
+{
+FAttributeSchema::FAttributeSchema(RuleFileInfoPtr InRuleInfo) : RuleInfo(std::move(InRuleInfo))
+{
+	for (size_t AttributeIndex = 0; AttributeIndex < RuleInfo->getNumAttributes(); AttributeIndex++)
+	{
+		const prt::RuleFileInfo::Entry* Entry = RuleInfo->getAttribute(AttributeIndex);
+		if (Entry->getNumParameters() != 0)
+		{
+			continue;
+		}
+
+		// We only support the default style for the moment
+		const FString Style(WCHAR_TO_TCHAR(prtu::getStyle(Entry->getName()).c_str()));
+		if (Style != DEFAULT_STYLE)
+		{
+			continue;
+		}
+
+		const FString Name = WCHAR_TO_TCHAR(Entry->getName());
+		const TSubclassOf<URuleAttribute> Class = GetAttributeClass(Entry);
+		if (!Class || AttributeIndices.Contains(Name))
+		{
+			continue;
+		}
+
+		FRuleAttributeInfo& Info = Attributes.AddDefaulted_GetRef();
+		Info.Name = Name;
+		Info.DisplayName = WCHAR_TO_TCHAR(prtu::removeImport(prtu::removeStyle(Entry->getName())).c_str());
+		Info.Key = Entry->getName();
+		Info.Class = Class;
+		Info.Entry = Entry;
+		AttributeIndices.Add(Name, Attributes.Num() - 1);
+	}
+}
+
+const FRuleAttributeInfo* FAttributeSchema::Find(const FString& Name) const
+{
+	const int32* Index = AttributeIndices.Find(Name);
+	return Index ? &Attributes[*Index] : nullptr;
+}
+
+void FAttributeSchema::CreateTemplates() const
+{
+	check(IsInGameThread());
+
+	if (bTemplatesCreated)
+	{
+		return;
+	}
+	bTemplatesCreated = true;
+
+	// The templates and their annotations are shared and must never be saved with the attributes referencing them
+	UPackage* TransientPackage = GetTransientPackage();
+	Templates.Reserve(Attributes.Num());
+	for (const FRuleAttributeInfo& Info : Attributes)
+	{
+		URuleAttribute* Template = NewObject<URuleAttribute>(TransientPackage, Info.Class, NAME_None, RF_Transient);
+		Template->Name = Info.Name;
+		Template->DisplayName = Info.DisplayName;
+		ParseAttributeAnnotations(Info.Entry, *Template, TransientPackage);
+
+		if (UAttributeAnnotation* Annotation = Template->GetAnnotation())
+		{
+			Annotation->SetFlags(RF_Transient);
+		}
+
+		Templates.Add(Template->Hidden ? nullptr : Template);
+	}
+}
+
+TMap<FString, URuleAttribute*> FAttributeSchema::CreateAttributes(const prt::AttributeMap& Values, UObject* const Outer) const
+{
+	CreateTemplates();
+
+	TMap<FString, URuleAttribute*> UnrealAttributes;
+	UnrealAttributes.Reserve(Attributes.Num());
+	for (int32 AttributeIndex = 0; AttributeIndex < Attributes.Num(); ++AttributeIndex)
+	{
+		const URuleAttribute* Template = Templates[AttributeIndex];
+		if (!Template)
+		{
+			continue;
+		}
+
+		URuleAttribute* Attribute = NewObject<URuleAttribute>(Outer, Template->GetClass());
+		Attribute->CopyInfo(Template);
+		SetValue(Attribute, Values, Attributes[AttributeIndex].Key);
+		UnrealAttributes.Add(Template->Name, Attribute);
+	}
+	return UnrealAttributes;
+}
+
+void FAttributeSchema::BindAttributes(const TMap<FString, URuleAttribute*>& InAttributes) const
+{
+	CreateTemplates();
+
+	for (const TPair<FString, URuleAttribute*>& AttributeEntry : InAttributes)
+	{
+		const int32* Index = AttributeIndices.Find(AttributeEntry.Key);
+		const URuleAttribute* Template = Index ? Templates[*Index] : nullptr;
+		if (Template && AttributeEntry.Value && AttributeEntry.Value->GetClass() == Template->GetClass())
+		{
+			AttributeEntry.Value->CopyInfo(Template);
+		}
+	}
+}
+
+void FAttributeSchema::AddReferencedObjects(FReferenceCollector& Collector) const
+{
+	Collector.AddReferencedObjects(Templates);
+}
+} // namespace Vitruvio
@@ -0,0 +1,172 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RulePackage.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/CustomVersion.h"
+
+namespace
+{
+struct FRulePackageCustomVersion
+{
+	enum Type
+	{
+		// The content is stored as an inline byte array
+		BeforeCustomVersionWasAdded = 0,
+		// The content is stored as bulk data together with its hash
+		BulkData,
+
+		VersionPlusOne,
+		LatestVersion = VersionPlusOne - 1
+	};
+
+	static const FGuid GUID;
+};
+
+const FGuid FRulePackageCustomVersion::GUID(0xC913BD37, 0xD84844A7, 0x9C2AC124, 0xA0C0EAC7);
+FCustomVersionRegistration GRegisterRulePackageCustomVersion(FRulePackageCustomVersion::GUID, FRulePackageCustomVersion::LatestVersion,
+															 TEXT("VitruvioRulePackage"));
+} // namespace
+
+void URulePackage::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	Ar.UsingCustomVersion(FRulePackageCustomVersion::GUID);
+
+	if (Ar.IsLoading() && Ar.CustomVer(FRulePackageCustomVersion::GUID) < FRulePackageCustomVersion::BulkData)
+	{
+		// Older assets store the content as an inline array. It is moved into the bulk data and stays resident until the asset is resaved.
+		int32 NumBytes = 0;
+		Ar << NumBytes;
+		FSHAHash Hash;
+		{
+			FScopeLock Lock(&DataLock);
+			Data.Lock(LOCK_READ_WRITE);
+			void* Dest = Data.Realloc(NumBytes);
+			Ar.Serialize(Dest, NumBytes);
+			FSHA1::HashBuffer(Dest, NumBytes, Hash.Hash);
+			Data.Unlock();
+		}
+
+		FScopeLock Lock(&ContentHashLock);
+		ContentHash = Hash;
+		return;
+	}
+
+	{
+		FScopeLock Lock(&ContentHashLock);
+		Ar << ContentHash;
+	}
+
+	FScopeLock Lock(&DataLock);
+	// Store the content at the end of the package file so that it is not loaded together with the asset
+	Data.SetBulkDataFlags(BULKDATA_Force_NOT_InlinePayload);
+	Data.Serialize(Ar, this);
+}
+
+void URulePackage::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+
+	FScopeLock Lock(&DataLock);
+	if (CumulativeResourceSize.GetResourceSizeMode() == EResourceSizeMode::EstimatedTotal || Data.IsBulkDataLoaded())
+	{
+		CumulativeResourceSize.AddDedicatedSystemMemoryBytes(Data.GetBulkDataSize());
+	}
+}
+
+bool URulePackage::ImportData(const FString& RpkPath)
+{
+	const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*RpkPath));
+	if (!Reader)
+	{
+		return false;
+	}
+
+	const int64 NumBytes = Reader->TotalSize();
+	FSHAHash Hash;
+	{
+		FScopeLock Lock(&DataLock);
+		Data.Lock(LOCK_READ_WRITE);
+		void* Dest = Data.Realloc(NumBytes);
+		Reader->Serialize(Dest, NumBytes);
+		FSHA1::HashBuffer(Dest, NumBytes, Hash.Hash);
+		Data.Unlock();
+	}
+
+	FScopeLock Lock(&ContentHashLock);
+	ContentHash = Hash;
+
+	return Reader->Close();
+}
+
+bool URulePackage::SaveDataToFile(const FString& Path) const
+{
+	const TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Path));
+	if (!Writer)
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&DataLock);
+
+	// Content which has just been imported or loaded from an older asset is resident
+	if (Data.IsBulkDataLoaded())
+	{
+		const int64 NumBytes = Data.GetBulkDataSize();
+		Writer->Serialize(const_cast<void*>(Data.Lock(LOCK_READ_ONLY)), NumBytes);
+		Data.Unlock();
+		return Writer->Close();
+	}
+
+	// Otherwise the content is read with a streaming request on its own file handle. Loading it through the bulk data would seek the archive of
+	// the package linker, which is not thread safe against loading on the game thread.
+	if (!Data.CanLoadFromDisk())
+	{
+		return false;
+	}
+
+	const TUniquePtr<IBulkDataIORequest> Request(Data.CreateStreamingRequest(AIOP_Normal, nullptr, nullptr));
+	if (!Request || !Request->WaitCompletion())
+	{
+		return false;
+	}
+
+	uint8* Content = Request->GetReadResults();
+	if (!Content)
+	{
+		return false;
+	}
+
+	Writer->Serialize(Content, Request->GetSize());
+	FMemory::Free(Content);
+
+	return Writer->Close();
+}
+
+int64 URulePackage::GetDataSize() const
+{
+	FScopeLock Lock(&DataLock);
+	return Data.GetBulkDataSize();
+}
+
+FSHAHash URulePackage::GetContentHash() const
+{
+	FScopeLock Lock(&ContentHashLock);
+	return ContentHash;
+}
@@ -63,10 +63,35 @@ void UnrealCallbacks::addMesh(const wchar_t* name, int32_t prototypeId, const do
 
 							  const uint32_t* faceRanges, size_t faceRangesSize, const prt::AttributeMap** materials)
 {
-	FMeshDescription Description;
+	// Encoders which do not poll isCanceled still call addMesh, skip at least the conversion of the discarded output
+	if (isCanceled())
+	{
+		return;
+	}
+
+	// Initial shapes are named by their index, see GetInitialShapeName
+	TCHAR* NameEnd = nullptr;
+	const uint64 ParsedIndex = FCString::Strtoui64(name, &NameEnd, 10);
+	if (NameEnd == name || *NameEnd != TEXT('\0') || ParsedIndex >= static_cast<uint64>(Meshes.Num()))
+	{
+		UE_LOG(LogUnrealCallbacks, Error, TEXT("Mesh of initial shape \"%s\" can not be assigned to an initial shape"), name);
+		return;
+	}
+	const int32 initialShapeIndex = static_cast<int32>(ParsedIndex);
+	CurrentInitialShapeIndex = initialShapeIndex;
+
+	// The mesh is built in place and afterwards only shared to avoid copying the geometry again on its way to the static mesh
+	const TSharedRef<Vitruvio::FGeneratedMesh, ESPMode::ThreadSafe> Mesh = MakeShared<Vitruvio::FGeneratedMesh, ESPMode::ThreadSafe>();
+	FMeshDescription& Description = Mesh->MeshDescription;
 	FStaticMeshAttributes Attributes(Description);
 	Attributes.Register();
 
+	Description.ReserveNewVertices(vtxSize / 3);
+	Description.ReserveNewVertexInstances(vertexIndicesSize);
+	Description.ReserveNewPolygons(faceVertexCountsSize);
+	Description.ReserveNewPolygonGroups(faceRangesSize);
+	Mesh->Materials.Reserve(faceRangesSize);
+
 	if (uvSets > 8)
 	{
 		UE_LOG(LogUnrealCallbacks, Error, TEXT("Mesh %s uses %llu UV sets but only 8 are allowed. Clamping UV sets to 8."), name, uvSets);
@@ -91,7 +116,8 @@ void UnrealCallbacks::addMesh(const wchar_t* name, int32_t prototypeId, const do
 	BaseUVIndex.Init(0, uvSets);
 
 	size_t PolygonGroupStartIndex = 0;
-	TArray<Vitruvio::FMaterialAttributeContainer> MeshMaterials;
+	TSet<FName> MaterialSlots;
+	TArray<FVertexInstanceID> PolygonVertexInstances;
 	for (size_t PolygonGroupIndex = 0; PolygonGroupIndex < faceRangesSize; ++PolygonGroupIndex)
 	{
 		const size_t PolygonFaceCount = faceRanges[PolygonGroupIndex];
@@ -99,9 +125,16 @@ void UnrealCallbacks::addMesh(const wchar_t* name, int32_t prototypeId, const do
 		const FPolygonGroupID PolygonGroupId = Description.CreatePolygonGroup();
 
 		Vitruvio::FMaterialAttributeContainer MaterialContainer(materials[PolygonGroupIndex]);
-		const FName MaterialSlot = FName(MaterialContainer.Name);
+
+		// Material slot names have to be unique since every polygon group gets its own material slot in the static mesh
+		FName MaterialSlot = FName(MaterialContainer.Name);
+		for (int32 SlotNumber = 1; MaterialSlots.Contains(MaterialSlot); ++SlotNumber)
+		{
+			MaterialSlot = FName(*MaterialContainer.Name, SlotNumber);
+		}
+		MaterialSlots.Add(MaterialSlot);
 		Attributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupId] = MaterialSlot;
-		MeshMaterials.Add(MaterialContainer);
+		Mesh->Materials.Add(MoveTemp(MaterialContainer));
 
 		// Create Geometry
 		const auto Normals = Attributes.GetVertexInstanceNormals();
@@ -111,7 +144,7 @@ void UnrealCallbacks::addMesh(const wchar_t* name, int32_t prototypeId, const do
 			check(PolygonGroupStartIndex + FaceIndex < faceVertexCountsSize);
 
 			const size_t FaceVertexCount = faceVertexCounts[PolygonGroupStartIndex + FaceIndex];
-			TArray<FVertexInstanceID> PolygonVertexInstances;
+			PolygonVertexInstances.Reset();
 
 			if (FaceVertexCount >= 3)
 			{
@@ -154,14 +187,23 @@ void UnrealCallbacks::addMesh(const wchar_t* name, int32_t prototypeId, const do
 
 	if (BaseVertexIndex > 0)
 	{
-		Materials.Add(prototypeId, MeshMaterials);
-		Meshes.Add(prototypeId, MoveTemp(Description));
+		// Collision data is created here on the generate thread instead of on the game thread when the result is applied
+		Mesh->CollisionData = MakeShared<const Vitruvio::FCollisionData, ESPMode::ThreadSafe>(Vitruvio::CreateCollisionData(Description));
+		Mesh->ContentHash = Vitruvio::ComputeMeshContentHash(Description, Mesh->Materials);
+		Meshes[initialShapeIndex].Add(prototypeId, Mesh);
 	}
 }
 
 void UnrealCallbacks::addInstance(int32_t prototypeId, const double* transform, const prt::AttributeMap** instanceMaterials,
 								  size_t numInstanceMaterials)
 {
+	if (isCanceled())
+	{
+		return;
+	}
+
+	const int32 initialShapeIndex = CurrentInitialShapeIndex;
+
 	const FMatrix TransformationMat(GetColumn(transform, 0), GetColumn(transform, 1), GetColumn(transform, 2), GetColumn(transform, 3));
 	const int32 SignumDet = FMath::Sign(TransformationMat.Determinant());
 
@@ -181,7 +223,7 @@ void UnrealCallbacks::addInstance(int32_t prototypeId, const double* transform,
 	const FVector CEScale = FVector(Scale.X, Scale.Z, Scale.Y);
 	const FVector CETranslation = FVector(Translation.X, Translation.Z, Translation.Y) * PRT_TO_UE_SCALE;
 
-	if (!Meshes.Contains(prototypeId))
+	if (!Meshes[initialShapeIndex].Contains(prototypeId))
 	{
 		UE_LOG(LogUnrealCallbacks, Warning, TEXT("No mesh found for prototypeId %d"), prototypeId);
 		return;
@@ -199,42 +241,42 @@ void UnrealCallbacks::addInstance(int32_t prototypeId, const double* transform,
 		}
 	}
 
-	Instances.FindOrAdd({prototypeId, MaterialOverrides}).Add(Transform);
+	Instances[initialShapeIndex].FindOrAdd({prototypeId, MaterialOverrides}).Add(Transform);
 }
 
 prt::Status UnrealCallbacks::attrBool(size_t isIndex, int32_t shapeID, const wchar_t* key, bool value)
 {
-	AttributeMapBuilder->setBool(key, value);
+	GetAttributeMapBuilder(isIndex)->setBool(key, value);
 	return prt::STATUS_OK;
 }
 
 prt::Status UnrealCallbacks::attrFloat(size_t isIndex, int32_t shapeID, const wchar_t* key, double value)
 {
-	AttributeMapBuilder->setFloat(key, value);
+	GetAttributeMapBuilder(isIndex)->setFloat(key, value);
 	return prt::STATUS_OK;
 }
 
 prt::Status UnrealCallbacks::attrString(size_t isIndex, int32_t shapeID, const wchar_t* key, const wchar_t* value)
 {
-	AttributeMapBuilder->setString(key, value);
+	GetAttributeMapBuilder(isIndex)->setString(key, value);
 	return prt::STATUS_OK;
 }
 
 prt::Status UnrealCallbacks::attrBoolArray(size_t isIndex, int32_t shapeID, const wchar_t* key, const bool* values, size_t size, size_t nRows)
 {
-	AttributeMapBuilder->setBoolArray(key, values, size);
+	GetAttributeMapBuilder(isIndex)->setBoolArray(key, values, size);
 	return prt::STATUS_OK;
 }
 
 prt::Status UnrealCallbacks::attrFloatArray(size_t isIndex, int32_t shapeID, const wchar_t* key, const double* values, size_t size, size_t nRows)
 {
-	AttributeMapBuilder->setFloatArray(key, values, size);
+	GetAttributeMapBuilder(isIndex)->setFloatArray(key, values, size);
 	return prt::STATUS_OK;
 }
 
 prt::Status UnrealCallbacks::attrStringArray(size_t isIndex, int32_t shapeID, const wchar_t* key, const wchar_t* const* values, size_t size,
 											 size_t nRows)
 {
-	AttributeMapBuilder->setStringArray(key, values, size);
+	GetAttributeMapBuilder(isIndex)->setStringArray(key, values, size);
 	return prt::STATUS_OK;
 }
@@ -25,51 +25,84 @@
 #include "MeshDescription.h"
 #include "Modules/ModuleManager.h"
 
+#include <string>
+
 DECLARE_LOG_CATEGORY_EXTERN(LogUnrealCallbacks, Log, All);
 
 class UnrealCallbacks final : public IUnrealCallbacks
 {
 	AttributeMapBuilderUPtr& AttributeMapBuilder;
+	// Optional builders per initial shape (indexed by the initial shape index) for evaluating the attributes of many initial shapes at once
+	AttributeMapBuilderVector* AttributeMapBuilders = nullptr;
+
+	// Generated output per initial shape (indexed by the initial shape index passed to prt::generate). The encoder does not pass the index
+	// to addMesh and addInstance, initial shapes are therefore named by their index (see GetInitialShapeName).
+	TArray<Vitruvio::FInstanceMap> Instances;
+	TArray<TMap<int32, Vitruvio::FGeneratedMeshPtr>> Meshes;
 
-	Vitruvio::FInstanceMap Instances;
-	TMap<int32, FMeshDescription> Meshes;
-	TMap<int32, TArray<Vitruvio::FMaterialAttributeContainer>> Materials;
+	// Initial shape of the last addMesh call. The encoder adds the meshes of an initial shape before its instances.
+	int32 CurrentInitialShapeIndex = 0;
 
 	UMaterial* OpaqueParent;
 	UMaterial* MaskedParent;
 	UMaterial* TranslucentParent;
 
+	// Polled by the encoder to abort the current generate call
+	TFunction<bool()> IsCanceledCallback;
+
 public:
 	~UnrealCallbacks() override = default;
-	UnrealCallbacks(AttributeMapBuilderUPtr& AttributeMapBuilder, UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent)
-		: AttributeMapBuilder(AttributeMapBuilder), OpaqueParent(OpaqueParent), MaskedParent(MaskedParent), TranslucentParent(TranslucentParent)
+	UnrealCallbacks(AttributeMapBuilderUPtr& AttributeMapBuilder, UMaterial* OpaqueParent, UMaterial* MaskedParent, UMaterial* TranslucentParent,
+					size_t NumInitialShapes = 1, TFunction<bool()> IsCanceledCallback = nullptr)
+		: AttributeMapBuilder(AttributeMapBuilder), OpaqueParent(OpaqueParent), MaskedParent(MaskedParent), TranslucentParent(TranslucentParent),
+		  IsCanceledCallback(MoveTemp(IsCanceledCallback))
+	{
+		Instances.SetNum(NumInitialShapes);
+		Meshes.SetNum(NumInitialShapes);
+	}
+
+	/** Evaluated attributes of every initial shape are written to the builder with the same index. */
+	explicit UnrealCallbacks(AttributeMapBuilderVector& AttributeMapBuilders)
+		: UnrealCallbacks(AttributeMapBuilders.front(), nullptr, nullptr, nullptr, AttributeMapBuilders.size())
 	{
+		this->AttributeMapBuilders = &AttributeMapBuilders;
 	}
 
 	static const int32 NO_PROTOTYPE_INDEX = -1;
 
-	const Vitruvio::FInstanceMap& GetInstances() const
+	/** Returns the name an initial shape needs to be created with so that its generated output is assigned to the given index. */
+	static std::wstring GetInitialShapeName(size_t InitialShapeIndex)
 	{
-		return Instances;
+		return std::to_wstring(InitialShapeIndex);
 	}
 
-	const TMap<int32, FMeshDescription>& GetMeshes() const
+	prt::AttributeMapBuilder* GetAttributeMapBuilder(size_t InitialShapeIndex) const
 	{
-		return Meshes;
+		return AttributeMapBuilders ? (*AttributeMapBuilders)[InitialShapeIndex].get() : AttributeMapBuilder.get();
 	}
 
-	const TMap<int32, TArray<Vitruvio::FMaterialAttributeContainer>>& GetMaterials() const
+	size_t GetNumInitialShapes() const
 	{
-		return Materials;
+		return Instances.Num();
 	}
 
-	const FMeshDescription& GetMeshById(int32 PrototypId) const
+	const Vitruvio::FInstanceMap& GetInstances(size_t InitialShapeIndex = 0) const
 	{
-		return Meshes[PrototypId];
+		return Instances[InitialShapeIndex];
+	}
+
+	const TMap<int32, Vitruvio::FGeneratedMeshPtr>& GetMeshes(size_t InitialShapeIndex = 0) const
+	{
+		return Meshes[InitialShapeIndex];
+	}
+
+	const Vitruvio::FGeneratedMeshPtr& GetMeshById(int32 PrototypId, size_t InitialShapeIndex = 0) const
+	{
+		return Meshes[InitialShapeIndex][PrototypId];
 	}
 
 	/**
-	 * @param name initial shape name, optionally used to create primitive groups on output
+	 * @param name initial shape name, the index of the initial shape this mesh belongs to (see GetInitialShapeName)
 	 * @param prototypeId the id of the prototype or -1 of not cached
 	 * @param vtx vertex coordinate array
 	 * @param vtxSize of vertex coordinate array
@@ -117,6 +150,11 @@ public:
 	virtual void addInstance(int32_t prototypeId, const double* transform, const prt::AttributeMap** instanceMaterial,
 							 size_t numInstanceMaterials) override;
 
+	bool isCanceled() override
+	{
+		return IsCanceledCallback && IsCanceledCallback();
+	}
+
 	prt::Status generateError(size_t /*isIndex*/, prt::Status /*status*/, const wchar_t* message) override
 	{
 		UE_LOG(LogUnrealCallbacks, Error, TEXT("GENERATE ERROR: %s"), message)
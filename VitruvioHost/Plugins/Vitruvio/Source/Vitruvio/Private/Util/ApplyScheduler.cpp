@@ -0,0 +1,108 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ApplyScheduler.h"
+
+#include "VitruvioComponent.h"
+
+#include "Algo/StableSort.h"
+#include "Engine/World.h"
+#include "HAL/PlatformTime.h"
+
+namespace
+{
+float GetDistanceToViewSquared(const UVitruvioComponent* Component, const FVector& Location)
+{
+	const UWorld* World = Component->GetWorld();
+	if (!World || World->ViewLocationsRenderedLastFrame.Num() == 0)
+	{
+		return 0.0f;
+	}
+
+	float MinDistanceSquared = TNumericLimits<float>::Max();
+	for (const FVector& ViewLocation : World->ViewLocationsRenderedLastFrame)
+	{
+		MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared(ViewLocation, Location));
+	}
+	return MinDistanceSquared;
+}
+} // namespace
+
+namespace Vitruvio
+{
+FApplyScheduler::FApplyScheduler(double BudgetMilliseconds) : BudgetSeconds(BudgetMilliseconds / 1000.0)
+{
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FApplyScheduler::Tick));
+}
+
+FApplyScheduler::~FApplyScheduler()
+{
+	FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+}
+
+void FApplyScheduler::Schedule(UVitruvioComponent* Component)
+{
+	check(IsInGameThread());
+	Scheduled.AddUnique(Component);
+}
+
+bool FApplyScheduler::Tick(float DeltaTime)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_Vitruvio_ApplyScheduler_Tick);
+
+	Scheduled.RemoveAll([](const TWeakObjectPtr<UVitruvioComponent>& Component) { return !Component.IsValid(); });
+	if (Scheduled.Num() == 0)
+	{
+		return true;
+	}
+
+	// Sort once per frame by distance to the closest view, the order of components at the same distance (eg. no views) is kept
+	TArray<TPair<float, UVitruvioComponent*>> SortedComponents;
+	SortedComponents.Reserve(Scheduled.Num());
+	for (const TWeakObjectPtr<UVitruvioComponent>& Component : Scheduled)
+	{
+		SortedComponents.Emplace(GetDistanceToViewSquared(Component.Get(), Component->GetApplyLocation()), Component.Get());
+	}
+	Algo::StableSortBy(SortedComponents, [](const TPair<float, UVitruvioComponent*>& Entry) { return Entry.Key; });
+
+	const double StartTime = FPlatformTime::Seconds();
+	bool bBudgetExceeded = false;
+	for (const TPair<float, UVitruvioComponent*>& Entry : SortedComponents)
+	{
+		UVitruvioComponent* Component = Entry.Value;
+
+		// At least one step is executed per frame so that applying always progresses. A component which waits (eg. for textures) stays
+		// scheduled and the next one is applied in the meantime.
+		EApplyStepResult StepResult;
+		do
+		{
+			StepResult = Component->ApplyNextStep();
+			bBudgetExceeded = FPlatformTime::Seconds() - StartTime >= BudgetSeconds;
+		} while (StepResult == EApplyStepResult::Continue && !bBudgetExceeded);
+
+		if (StepResult == EApplyStepResult::Finished)
+		{
+			Scheduled.Remove(Component);
+		}
+
+		if (bBudgetExceeded)
+		{
+			break;
+		}
+	}
+
+	return true;
+}
+} // namespace Vitruvio
@@ -0,0 +1,55 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Containers/Ticker.h"
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class UVitruvioComponent;
+
+namespace Vitruvio
+{
+/**
+ * Applies generate results to their components on the game thread. Applying a result is split into steps (building meshes, creating
+ * components, adding instances) and the scheduler only runs as many steps per frame as fit into the configured time budget. Components
+ * closest to the camera are applied first.
+ */
+class FApplyScheduler
+{
+public:
+	explicit FApplyScheduler(double BudgetMilliseconds);
+	~FApplyScheduler();
+
+	FApplyScheduler(const FApplyScheduler&) = delete;
+	FApplyScheduler& operator=(const FApplyScheduler&) = delete;
+
+	/** Schedules the pending generate result of the given component to be applied. */
+	void Schedule(UVitruvioComponent* Component);
+
+	int32 GetNumScheduled() const
+	{
+		return Scheduled.Num();
+	}
+
+private:
+	bool Tick(float DeltaTime);
+
+	TArray<TWeakObjectPtr<UVitruvioComponent>> Scheduled;
+	double BudgetSeconds;
+	FDelegateHandle TickerHandle;
+};
+} // namespace Vitruvio
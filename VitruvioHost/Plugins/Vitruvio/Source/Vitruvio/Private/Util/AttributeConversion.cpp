@@ -17,119 +17,119 @@
 
 #include "AttributeConversion.h"
 
-#include "AnnotationParsing.h"
-
 #include "PRTTypes.h"
 #include "PRTUtils.h"
 #include "RuleAttributes.h"
 
-namespace
-{
-const FString DEFAULT_STYLE = TEXT("Default");
-
-URuleAttribute* CreateAttribute(const AttributeMapUPtr& AttributeMap, const prt::RuleFileInfo::Entry* AttrInfo, UObject* const Outer)
-{
-	const std::wstring Name(AttrInfo->getName());
-	switch (AttrInfo->getReturnType())
-	{
-	case prt::AAT_BOOL:
-	{
-		UBoolAttribute* BoolAttribute = NewObject<UBoolAttribute>(Outer);
-		BoolAttribute->Value = AttributeMap->getBool(Name.c_str());
-		return BoolAttribute;
-	}
-	case prt::AAT_INT:
-	case prt::AAT_FLOAT:
-	{
-		UFloatAttribute* FloatAttribute = NewObject<UFloatAttribute>(Outer);
-		FloatAttribute->Value = AttributeMap->getFloat(Name.c_str());
-		return FloatAttribute;
-	}
-	case prt::AAT_STR:
-	{
-		UStringAttribute* StringAttribute = NewObject<UStringAttribute>(Outer);
-		StringAttribute->Value = WCHAR_TO_TCHAR(AttributeMap->getString(Name.c_str()));
-		return StringAttribute;
-	}
-	case prt::AAT_UNKNOWN:
-	case prt::AAT_VOID:
-	case prt::AAT_BOOL_ARRAY:
-	case prt::AAT_FLOAT_ARRAY:
-	case prt::AAT_STR_ARRAY:
-	default:
-		return nullptr;
-	}
-}
-} // namespace
-
 namespace Vitruvio
 {
-TMap<FString, URuleAttribute*> ConvertAttributeMap(const AttributeMapUPtr& AttributeMap, const RuleFileInfoUPtr& RuleInfo, UObject* const Outer)
+AttributeMapUPtr CreateAttributeMap(const TMap<FString, URuleAttribute*>& Attributes)
 {
-	TMap<FString, URuleAttribute*> UnrealAttributeMap;
-	for (size_t AttributeIndex = 0; AttributeIndex < RuleInfo->getNumAttributes(); AttributeIndex++)
+	AttributeMapBuilderUPtr AttributeMapBuilder(prt::AttributeMapBuilder::create());
+
+	for (const TPair<FString, URuleAttribute*>& AttributeEntry : Attributes)
 	{
-		const prt::RuleFileInfo::Entry* AttrInfo = RuleInfo->getAttribute(AttributeIndex);
-		if (AttrInfo->getNumParameters() != 0)
+		const URuleAttribute* Attribute = AttributeEntry.Value;
+
+		if (const UFloatAttribute* FloatAttribute = Cast<UFloatAttribute>(Attribute))
 		{
-			continue;
+			AttributeMapBuilder->setFloat(TCHAR_TO_WCHAR(*Attribute->Name), FloatAttribute->Value);
 		}
-
-		// We only support the default style for the moment
-		FString Style(WCHAR_TO_TCHAR(prtu::getStyle(AttrInfo->getName()).c_str()));
-		if (Style != DEFAULT_STYLE)
+		else if (const UStringAttribute* StringAttribute = Cast<UStringAttribute>(Attribute))
 		{
-			continue;
+			AttributeMapBuilder->setString(TCHAR_TO_WCHAR(*Attribute->Name), TCHAR_TO_WCHAR(*StringAttribute->Value));
 		}
-
-		const std::wstring Name(AttrInfo->getName());
-		if (UnrealAttributeMap.Contains(WCHAR_TO_TCHAR(Name.c_str())))
+		else if (const UBoolAttribute* BoolAttribute = Cast<UBoolAttribute>(Attribute))
 		{
-			continue;
+			AttributeMapBuilder->setBool(TCHAR_TO_WCHAR(*Attribute->Name), BoolAttribute->Value);
 		}
+	}
 
-		URuleAttribute* Attribute = CreateAttribute(AttributeMap, AttrInfo, Outer);
-
-		if (Attribute)
-		{
-			const FString AttributeName = WCHAR_TO_TCHAR(Name.c_str());
-			const FString DisplayName = WCHAR_TO_TCHAR(prtu::removeImport(prtu::removeStyle(Name.c_str())).c_str());
-			Attribute->Name = AttributeName;
-			Attribute->DisplayName = DisplayName;
+	return AttributeMapUPtr(AttributeMapBuilder->createAttributeMap(), PRTDestroyer());
+}
 
-			ParseAttributeAnnotations(AttrInfo, *Attribute, Outer);
+AttributeMapUPtr FAttributeMapBuilderCache::CreateAttributeMap(const TMap<FString, URuleAttribute*>& Attributes)
+{
+	NumUpdatedAttributes = 0;
 
-			if (!Attribute->Hidden)
+	if (AttributeMapBuilder && HasSameAttributes(Attributes))
+	{
+		for (FEntry& Entry : Entries)
+		{
+			UpdateEntry(Entry, false);
+		}
+	}
+	else
+	{
+		// Start with a new builder so that values of removed attributes are not passed to PRT anymore
+		AttributeMapBuilder.reset(prt::AttributeMapBuilder::create());
+		Entries.Reset(Attributes.Num());
+		for (const TPair<FString, URuleAttribute*>& AttributeEntry : Attributes)
+		{
+			FEntry& Entry = Entries.AddDefaulted_GetRef();
+			Entry.Attribute = AttributeEntry.Value;
+			if (Entry.Attribute)
 			{
-				UnrealAttributeMap.Add(AttributeName, Attribute);
+				Entry.Class = Entry.Attribute->GetClass();
+				Entry.Key = TCHAR_TO_WCHAR(*Entry.Attribute->Name);
+				UpdateEntry(Entry, true);
 			}
 		}
 	}
-	return UnrealAttributeMap;
+
+	return AttributeMapUPtr(AttributeMapBuilder->createAttributeMap(), PRTDestroyer());
 }
 
-AttributeMapUPtr CreateAttributeMap(const TMap<FString, URuleAttribute*>& Attributes)
+bool FAttributeMapBuilderCache::HasSameAttributes(const TMap<FString, URuleAttribute*>& Attributes) const
 {
-	AttributeMapBuilderUPtr AttributeMapBuilder(prt::AttributeMapBuilder::create());
+	if (Entries.Num() != Attributes.Num())
+	{
+		return false;
+	}
 
+	int32 EntryIndex = 0;
 	for (const TPair<FString, URuleAttribute*>& AttributeEntry : Attributes)
 	{
-		const URuleAttribute* Attribute = AttributeEntry.Value;
+		const FEntry& Entry = Entries[EntryIndex++];
+		if (Entry.Attribute != AttributeEntry.Value || (Entry.Attribute && Entry.Class != Entry.Attribute->GetClass()))
+		{
+			return false;
+		}
+	}
+	return true;
+}
 
-		if (const UFloatAttribute* FloatAttribute = Cast<UFloatAttribute>(Attribute))
+void FAttributeMapBuilderCache::UpdateEntry(FEntry& Entry, bool bForce)
+{
+	if (Entry.Class == UFloatAttribute::StaticClass())
+	{
+		const double Value = static_cast<const UFloatAttribute*>(Entry.Attribute)->Value;
+		if (bForce || Value != Entry.FloatValue)
 		{
-			AttributeMapBuilder->setFloat(TCHAR_TO_WCHAR(*Attribute->Name), FloatAttribute->Value);
+			Entry.FloatValue = Value;
+			AttributeMapBuilder->setFloat(Entry.Key.c_str(), Value);
+			NumUpdatedAttributes++;
 		}
-		else if (const UStringAttribute* StringAttribute = Cast<UStringAttribute>(Attribute))
+	}
+	else if (Entry.Class == UStringAttribute::StaticClass())
+	{
+		const FString& Value = static_cast<const UStringAttribute*>(Entry.Attribute)->Value;
+		if (bForce || !Value.Equals(Entry.StringValue, ESearchCase::CaseSensitive))
 		{
-			AttributeMapBuilder->setString(TCHAR_TO_WCHAR(*Attribute->Name), TCHAR_TO_WCHAR(*StringAttribute->Value));
+			Entry.StringValue = Value;
+			AttributeMapBuilder->setString(Entry.Key.c_str(), TCHAR_TO_WCHAR(*Value));
+			NumUpdatedAttributes++;
 		}
-		else if (const UBoolAttribute* BoolAttribute = Cast<UBoolAttribute>(Attribute))
+	}
+	else if (Entry.Class == UBoolAttribute::StaticClass())
+	{
+		const bool Value = static_cast<const UBoolAttribute*>(Entry.Attribute)->Value;
+		if (bForce || Value != Entry.BoolValue)
 		{
-			AttributeMapBuilder->setBool(TCHAR_TO_WCHAR(*Attribute->Name), BoolAttribute->Value);
+			Entry.BoolValue = Value;
+			AttributeMapBuilder->setBool(Entry.Key.c_str(), Value);
+			NumUpdatedAttributes++;
 		}
 	}
-
-	return AttributeMapUPtr(AttributeMapBuilder->createAttributeMap(), PRTDestroyer());
 }
 } // namespace Vitruvio
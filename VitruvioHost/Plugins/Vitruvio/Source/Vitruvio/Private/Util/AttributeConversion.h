@@ -20,9 +20,45 @@
 
 #include "CoreUObject.h"
 
+#include <string>
+
 namespace Vitruvio
 {
-TMap<FString, URuleAttribute*> ConvertAttributeMap(const AttributeMapUPtr& AttributeMap, const RuleFileInfoUPtr& RuleInfo, UObject* Outer);
-
 AttributeMapUPtr CreateAttributeMap(const TMap<FString, URuleAttribute*>& Attributes);
+
+/**
+ * Builds the attribute maps passed to PRT for the attributes of a single component. The PRT builder and the wide string names are kept
+ * between calls and only attributes whose values changed since the previous call are set again. If attributes have been added, removed or
+ * replaced all attributes are set again.
+ */
+class FAttributeMapBuilderCache
+{
+public:
+	AttributeMapUPtr CreateAttributeMap(const TMap<FString, URuleAttribute*>& Attributes);
+
+	/** Returns the number of attribute values which have been set by the previous call. */
+	int32 GetNumUpdatedAttributes() const
+	{
+		return NumUpdatedAttributes;
+	}
+
+private:
+	struct FEntry
+	{
+		const URuleAttribute* Attribute = nullptr;
+		const UClass* Class = nullptr;
+		std::wstring Key;
+
+		double FloatValue = 0;
+		bool BoolValue = false;
+		FString StringValue;
+	};
+
+	bool HasSameAttributes(const TMap<FString, URuleAttribute*>& Attributes) const;
+	void UpdateEntry(FEntry& Entry, bool bForce);
+
+	AttributeMapBuilderUPtr AttributeMapBuilder;
+	TArray<FEntry> Entries;
+	int32 NumUpdatedAttributes = 0;
+};
 } // namespace Vitruvio
@@ -0,0 +1,439 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Benchmarks.h"
+
+// Console commands which measure optimized code paths against their previous implementations. They are only meant for development and
+// therefore not compiled into shipping builds.
+#if !UE_BUILD_SHIPPING
+
+#include "AttributeConversion.h"
+#include "GeneratedModelHISMComponent.h"
+#include "OpacityMapClassification.h"
+#include "VitruvioModule.h"
+
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+namespace
+{
+/** Returns the best time in milliseconds of the given number of runs of the function. */
+template <typename F>
+double MeasureBest(int32 NumRepetitions, F Function)
+{
+	double Best = TNumericLimits<double>::Max();
+	for (int32 Repetition = 0; Repetition < NumRepetitions; ++Repetition)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		Function();
+		Best = FMath::Min(Best, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	}
+	return Best;
+}
+
+double GetSpeedup(double ReferenceTime, double Time)
+{
+	return Time > 0.0 ? ReferenceTime / Time : 0.0;
+}
+
+// Allocation counting
+
+// Only written by the owning thread, benchmarks compare the counter of the calling thread before and after a measurement
+thread_local uint64 NumThreadAllocations = 0;
+
+/** Forwards to the wrapped allocator and counts the allocations of each thread. */
+class FAllocationCountingMalloc final : public FMalloc
+{
+public:
+	explicit FAllocationCountingMalloc(FMalloc* InnerMalloc) : InnerMalloc(InnerMalloc) {}
+
+	void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		++NumThreadAllocations;
+		return InnerMalloc->Malloc(Count, Alignment);
+	}
+
+	void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		if (Count > 0)
+		{
+			++NumThreadAllocations;
+		}
+		return InnerMalloc->Realloc(Original, Count, Alignment);
+	}
+
+	void Free(void* Original) override
+	{
+		InnerMalloc->Free(Original);
+	}
+
+	bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return InnerMalloc->GetAllocationSize(Original, SizeOut);
+	}
+
+	SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return InnerMalloc->QuantizeSize(Count, Alignment);
+	}
+
+	void Trim(bool bTrimThreadCaches) override
+	{
+		InnerMalloc->Trim(bTrimThreadCaches);
+	}
+
+	void SetupTLSCachesOnCurrentThread() override
+	{
+		InnerMalloc->SetupTLSCachesOnCurrentThread();
+	}
+
+	void ClearAndDisableTLSCachesOnCurrentThread() override
+	{
+		InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread();
+	}
+
+	void InitializeStatsMetadata() override
+	{
+		InnerMalloc->InitializeStatsMetadata();
+	}
+
+	void UpdateStats() override
+	{
+		InnerMalloc->UpdateStats();
+	}
+
+	void GetAllocatorStats(FGenericMemoryStats& OutStats) override
+	{
+		InnerMalloc->GetAllocatorStats(OutStats);
+	}
+
+	void DumpAllocatorStats(FOutputDevice& Ar) override
+	{
+		InnerMalloc->DumpAllocatorStats(Ar);
+	}
+
+	bool IsInternallyThreadSafe() const override
+	{
+		return InnerMalloc->IsInternallyThreadSafe();
+	}
+
+	bool ValidateHeap() override
+	{
+		return InnerMalloc->ValidateHeap();
+	}
+
+	const TCHAR* GetDescriptiveName() override
+	{
+		return InnerMalloc->GetDescriptiveName();
+	}
+
+private:
+	FMalloc* InnerMalloc;
+};
+
+bool bAllocationCounterInstalled = false;
+
+// Instance apply
+
+constexpr int32 DefaultMaxInstanceCount = 100000;
+constexpr int32 NumInstanceRepetitions = 3;
+
+TArray<FTransform> CreateGridTransforms(int32 Count)
+{
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Count)));
+
+	TArray<FTransform> Transforms;
+	Transforms.Reserve(Count);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		Transforms.Emplace(FVector((Index % GridSize) * 200.0f, (Index / GridSize) * 200.0f, 0.0f));
+	}
+	return Transforms;
+}
+
+/** Creates and registers an instance component holding the given transforms and destroys it again. */
+void ApplyInstances(AActor* Owner, UStaticMesh* Mesh, const TArray<FTransform>& Transforms, bool bBulkInsertion)
+{
+	auto InstancedComponent = NewObject<UGeneratedModelHISMComponent>(Owner, NAME_None, RF_Transient);
+	InstancedComponent->SetStaticMesh(Mesh);
+	if (bBulkInsertion)
+	{
+		InstancedComponent->AddInstances(Transforms, false);
+	}
+	else
+	{
+		for (const FTransform& Transform : Transforms)
+		{
+			InstancedComponent->AddInstance(Transform);
+		}
+	}
+	InstancedComponent->RegisterComponent();
+	InstancedComponent->DestroyComponent();
+}
+
+void BenchmarkInstanceApply(const TArray<FString>& Args, UWorld* World)
+{
+	if (!World)
+	{
+		UE_LOG(LogUnrealPrt, Warning, TEXT("Instance benchmark requires a world"));
+		return;
+	}
+
+	const int32 MaxInstanceCount = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : DefaultMaxInstanceCount;
+
+	UStaticMesh* Mesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (!Mesh)
+	{
+		UE_LOG(LogUnrealPrt, Warning, TEXT("Instance benchmark could not load the benchmark mesh"));
+		return;
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.ObjectFlags = RF_Transient;
+	AActor* Owner = World->SpawnActor<AActor>(SpawnParameters);
+	USceneComponent* Root = NewObject<USceneComponent>(Owner, NAME_None, RF_Transient);
+	Owner->SetRootComponent(Root);
+	Root->RegisterComponent();
+
+	UE_LOG(LogUnrealPrt, Display, TEXT("Instance apply benchmark (best of %d, milliseconds)"), NumInstanceRepetitions);
+	UE_LOG(LogUnrealPrt, Display, TEXT("%10s %14s %14s %10s"), TEXT("Instances"), TEXT("AddInstance"), TEXT("AddInstances"), TEXT("Speedup"));
+	for (int32 InstanceCount = 10; InstanceCount <= MaxInstanceCount; InstanceCount *= 10)
+	{
+		const TArray<FTransform> Transforms = CreateGridTransforms(InstanceCount);
+		const double PerTransformTime = MeasureBest(NumInstanceRepetitions, [&]() { ApplyInstances(Owner, Mesh, Transforms, false); });
+		const double BulkTime = MeasureBest(NumInstanceRepetitions, [&]() { ApplyInstances(Owner, Mesh, Transforms, true); });
+		UE_LOG(LogUnrealPrt, Display, TEXT("%10d %14.3f %14.3f %9.1fx"), InstanceCount, PerTransformTime, BulkTime,
+			   GetSpeedup(PerTransformTime, BulkTime));
+	}
+
+	World->DestroyActor(Owner);
+}
+
+FAutoConsoleCommandWithWorldAndArgs BenchmarkInstanceApplyCommand(
+	TEXT("Vitruvio.BenchmarkInstanceApply"),
+	TEXT("Measures the time to apply instance components with per-transform versus bulk insertion for increasing instance counts. ")
+		TEXT("Usage: Vitruvio.BenchmarkInstanceApply [MaxInstanceCount]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkInstanceApply));
+
+// Opacity map classification
+
+constexpr int32 DefaultOpacityMapSize = 4096;
+constexpr int32 NumOpacityRepetitions = 5;
+
+/** The per pixel loop which has been used to count opacity map pixels before, kept as a reference. */
+Vitruvio::FOpacityMapHistogram CountOpacityMapPixelsReference(const FColor* Pixels, int64 NumPixels, bool bUseAlphaChannel)
+{
+	Vitruvio::FOpacityMapHistogram Histogram;
+	Histogram.TotalPixels = NumPixels;
+	for (int64 Index = 0; Index < NumPixels; ++Index)
+	{
+		const float Value = static_cast<float>(bUseAlphaChannel ? Pixels[Index].A : Pixels[Index].R) / 0xFF;
+		if (Value < 0.02)
+		{
+			Histogram.BlackPixels++;
+		}
+		else if (Value > 0.98)
+		{
+			Histogram.WhitePixels++;
+		}
+	}
+	return Histogram;
+}
+
+/** Creates a mostly black and white image with some gray pixels, similar to typical (masked) opacity maps. */
+TArray<FColor> CreateOpacityMap(int32 Size)
+{
+	FRandomStream Random(42);
+	TArray<FColor> Pixels;
+	Pixels.SetNumUninitialized(Size * Size);
+	for (FColor& Pixel : Pixels)
+	{
+		const float Choice = Random.GetFraction();
+		const uint8 Value = Choice < 0.45f ? 0 : Choice < 0.9f ? 255 : static_cast<uint8>(Random.RandRange(0, 255));
+		Pixel = FColor(Value, Value, Value, Value);
+	}
+	return Pixels;
+}
+
+void BenchmarkOpacityClassification(const TArray<FString>& Args)
+{
+	const int32 Size = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : DefaultOpacityMapSize;
+	const TArray<FColor> Pixels = CreateOpacityMap(Size);
+	const FColor* Data = Pixels.GetData();
+	const int64 NumPixels = Pixels.Num();
+
+	Vitruvio::FOpacityMapHistogram Reference;
+	Vitruvio::FOpacityMapHistogram Scalar;
+	Vitruvio::FOpacityMapHistogram Vectorized;
+	const double ReferenceTime =
+		MeasureBest(NumOpacityRepetitions, [&]() { Reference = CountOpacityMapPixelsReference(Data, NumPixels, true); });
+	const double ScalarTime = MeasureBest(NumOpacityRepetitions, [&]() { Scalar = Vitruvio::CountOpacityMapPixelsScalar(Data, NumPixels, true); });
+	const double VectorizedTime =
+		MeasureBest(NumOpacityRepetitions, [&]() { Vectorized = Vitruvio::CountOpacityMapPixels(Data, NumPixels, true); });
+
+	const bool bMatches = Reference.BlackPixels == Vectorized.BlackPixels && Reference.WhitePixels == Vectorized.WhitePixels &&
+						  Scalar.BlackPixels == Vectorized.BlackPixels && Scalar.WhitePixels == Vectorized.WhitePixels;
+
+	UE_LOG(LogUnrealPrt, Display, TEXT("Opacity map classification benchmark, %dx%d BGRA8 (best of %d, milliseconds)"), Size, Size,
+		   NumOpacityRepetitions);
+	UE_LOG(LogUnrealPrt, Display, TEXT("%12s %12s %12s %10s"), TEXT("Reference"), TEXT("Scalar"), TEXT("Vectorized"), TEXT("Speedup"));
+	UE_LOG(LogUnrealPrt, Display, TEXT("%12.3f %12.3f %12.3f %9.1fx"), ReferenceTime, ScalarTime, VectorizedTime,
+		   GetSpeedup(ReferenceTime, VectorizedTime));
+	UE_LOG(LogUnrealPrt, Display, TEXT("Black: %lld, white: %lld, results %s"), Vectorized.BlackPixels, Vectorized.WhitePixels,
+		   bMatches ? TEXT("match") : TEXT("DIFFER"));
+}
+
+FAutoConsoleCommandWithArgs BenchmarkOpacityClassificationCommand(
+	TEXT("Vitruvio.BenchmarkOpacityClassification"),
+	TEXT("Measures the time to count the black and white pixels of a synthetic opacity map with the previous per pixel loop, the scalar ")
+		TEXT("and the vectorized kernel. Usage: Vitruvio.BenchmarkOpacityClassification [ImageSize]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkOpacityClassification));
+
+// Attribute map
+
+constexpr int32 DefaultNumAttributes = 80;
+constexpr int32 DefaultNumAttributeMapIterations = 1000;
+constexpr int32 NumAttributeMapRepetitions = 3;
+
+TMap<FString, URuleAttribute*> CreateAttributes(int32 NumAttributes)
+{
+	TMap<FString, URuleAttribute*> Attributes;
+	for (int32 AttributeIndex = 0; AttributeIndex < NumAttributes; ++AttributeIndex)
+	{
+		URuleAttribute* Attribute;
+		switch (AttributeIndex % 3)
+		{
+		case 0:
+		{
+			UFloatAttribute* FloatAttribute = NewObject<UFloatAttribute>(GetTransientPackage());
+			FloatAttribute->Value = AttributeIndex;
+			Attribute = FloatAttribute;
+			break;
+		}
+		case 1:
+		{
+			UStringAttribute* StringAttribute = NewObject<UStringAttribute>(GetTransientPackage());
+			StringAttribute->Value = FString::Printf(TEXT("Value %d"), AttributeIndex);
+			Attribute = StringAttribute;
+			break;
+		}
+		default:
+		{
+			UBoolAttribute* BoolAttribute = NewObject<UBoolAttribute>(GetTransientPackage());
+			BoolAttribute->Value = AttributeIndex % 2 == 0;
+			Attribute = BoolAttribute;
+			break;
+		}
+		}
+		Attribute->Name = FString::Printf(TEXT("Default$attribute%d"), AttributeIndex);
+		Attributes.Add(Attribute->Name, Attribute);
+	}
+	return Attributes;
+}
+
+struct FAttributeMapMeasurement
+{
+	double MicrosecondsPerCall = 0;
+	double AllocationsPerCall = 0;
+};
+
+/** Changes a single attribute (like a slider drag) before every call of the given function. */
+template <typename F>
+FAttributeMapMeasurement MeasureAttributeMap(UFloatAttribute* DraggedAttribute, int32 NumIterations, F CreateAttributeMap)
+{
+	const uint64 NumAllocationsBefore = NumThreadAllocations;
+	const double Time = MeasureBest(NumAttributeMapRepetitions, [&]() {
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			DraggedAttribute->Value = Iteration;
+			const AttributeMapUPtr AttributeMap = CreateAttributeMap();
+		}
+	});
+	const uint64 NumAllocations = NumThreadAllocations - NumAllocationsBefore;
+	return {Time * 1000.0 / NumIterations, static_cast<double>(NumAllocations) / (NumAttributeMapRepetitions * NumIterations)};
+}
+
+FString FormatAllocationsPerCall(double AllocationsPerCall)
+{
+	return bAllocationCounterInstalled ? FString::Printf(TEXT("%.1f"), AllocationsPerCall) : FString(TEXT("-"));
+}
+
+void BenchmarkAttributeMap(const TArray<FString>& Args)
+{
+	if (!VitruvioModule::Get().IsInitialized())
+	{
+		UE_LOG(LogUnrealPrt, Warning, TEXT("Attribute map benchmark requires an initialized PRT"));
+		return;
+	}
+
+	const int32 NumAttributes = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : DefaultNumAttributes;
+	const int32 NumIterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : DefaultNumAttributeMapIterations;
+
+	const TMap<FString, URuleAttribute*> Attributes = CreateAttributes(NumAttributes);
+	UFloatAttribute* DraggedAttribute = CastChecked<UFloatAttribute>(Attributes.CreateConstIterator().Value());
+
+	Vitruvio::FAttributeMapBuilderCache BuilderCache;
+	const FAttributeMapMeasurement Full =
+		MeasureAttributeMap(DraggedAttribute, NumIterations, [&]() { return Vitruvio::CreateAttributeMap(Attributes); });
+	const FAttributeMapMeasurement Cached =
+		MeasureAttributeMap(DraggedAttribute, NumIterations, [&]() { return BuilderCache.CreateAttributeMap(Attributes); });
+
+	UE_LOG(LogUnrealPrt, Display, TEXT("Attribute map benchmark, %d attributes, one changed attribute per call (%d calls, best of %d)"),
+		   NumAttributes, NumIterations, NumAttributeMapRepetitions);
+	UE_LOG(LogUnrealPrt, Display, TEXT("%10s %16s %20s"), TEXT(""), TEXT("us per call"), TEXT("allocations per call"));
+	UE_LOG(LogUnrealPrt, Display, TEXT("%10s %16.2f %20s"), TEXT("Full"), Full.MicrosecondsPerCall,
+		   *FormatAllocationsPerCall(Full.AllocationsPerCall));
+	UE_LOG(LogUnrealPrt, Display, TEXT("%10s %16.2f %20s"), TEXT("Cached"), Cached.MicrosecondsPerCall,
+		   *FormatAllocationsPerCall(Cached.AllocationsPerCall));
+	UE_LOG(LogUnrealPrt, Display, TEXT("Speedup: %.1fx, attributes set by the last cached call: %d"),
+		   GetSpeedup(Full.MicrosecondsPerCall, Cached.MicrosecondsPerCall), BuilderCache.GetNumUpdatedAttributes());
+	if (!bAllocationCounterInstalled)
+	{
+		UE_LOG(LogUnrealPrt, Display, TEXT("Start with -VitruvioCountAllocations to count the allocations"));
+	}
+}
+
+FAutoConsoleCommandWithArgs BenchmarkAttributeMapCommand(
+	TEXT("Vitruvio.BenchmarkAttributeMap"),
+	TEXT("Measures the time and the number of allocations (of the calling thread, requires -VitruvioCountAllocations) to build the PRT ")
+		TEXT("attribute map of a component from scratch and with the cached builder. ")
+		TEXT("Usage: Vitruvio.BenchmarkAttributeMap [NumAttributes] [NumIterations]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkAttributeMap));
+} // namespace
+
+namespace Vitruvio
+{
+void InstallBenchmarkAllocationCounter()
+{
+	if (bAllocationCounterInstalled || !FParse::Param(FCommandLine::Get(), TEXT("VitruvioCountAllocations")))
+	{
+		return;
+	}
+
+	// Installed once for the lifetime of the process and never removed, so no thread can call into a deleted allocator. Memory allocated
+	// before is freed through the proxy by the wrapped allocator.
+	GMalloc = new FAllocationCountingMalloc(GMalloc);
+	bAllocationCounterInstalled = true;
+}
+} // namespace Vitruvio
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,31 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace Vitruvio
+{
+/**
+ * Installs an allocator proxy which counts the allocations of each thread for the benchmark console commands if the process has been
+ * started with -VitruvioCountAllocations. Has to be called once while loading the module.
+ */
+void InstallBenchmarkAllocationCounter();
+} // namespace Vitruvio
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,280 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GenerateResultCache.h"
+
+#include "Misc/ScopeLock.h"
+
+#include <algorithm>
+#include <cwchar>
+#include <vector>
+
+namespace
+{
+// Has to be changed whenever the generated output changes for the same inputs (eg. changes to the encoder)
+const TCHAR* GENERATE_RESULT_CACHE_KEY_VERSION = TEXT("VitruvioGenerateResult_1");
+
+template <typename T>
+void UpdateHash(FSHA1& Sha, const T& Value)
+{
+	static_assert(TIsPODType<T>::Value, "only POD types can be hashed by value");
+	Sha.Update(reinterpret_cast<const uint8*>(&Value), sizeof(T));
+}
+
+void UpdateStringHash(FSHA1& Sha, const wchar_t* String)
+{
+	const size_t Length = String ? std::wcslen(String) : 0;
+	UpdateHash(Sha, static_cast<uint64>(Length));
+	Sha.Update(reinterpret_cast<const uint8*>(String), Length * sizeof(wchar_t));
+}
+
+void UpdateAttributeMapHash(FSHA1& Sha, const prt::AttributeMap* AttributeMap)
+{
+	if (!AttributeMap)
+	{
+		UpdateHash(Sha, static_cast<uint64>(0));
+		return;
+	}
+
+	size_t KeyCount = 0;
+	wchar_t const* const* Keys = AttributeMap->getKeys(&KeyCount);
+
+	// The key order of an attribute map is not defined
+	std::vector<const wchar_t*> SortedKeys(Keys, Keys + KeyCount);
+	std::sort(SortedKeys.begin(), SortedKeys.end(), [](const wchar_t* A, const wchar_t* B) { return std::wcscmp(A, B) < 0; });
+
+	UpdateHash(Sha, static_cast<uint64>(KeyCount));
+	for (const wchar_t* Key : SortedKeys)
+	{
+		UpdateStringHash(Sha, Key);
+
+		const prt::AttributeMap::PrimitiveType Type = AttributeMap->getType(Key);
+		UpdateHash(Sha, static_cast<int32>(Type));
+
+		size_t Count = 0;
+		switch (Type)
+		{
+		case prt::AttributeMap::PT_BOOL:
+			UpdateHash(Sha, AttributeMap->getBool(Key));
+			break;
+		case prt::AttributeMap::PT_FLOAT:
+			UpdateHash(Sha, AttributeMap->getFloat(Key));
+			break;
+		case prt::AttributeMap::PT_INT:
+			UpdateHash(Sha, AttributeMap->getInt(Key));
+			break;
+		case prt::AttributeMap::PT_STRING:
+			UpdateStringHash(Sha, AttributeMap->getString(Key));
+			break;
+		case prt::AttributeMap::PT_BOOL_ARRAY:
+		{
+			const bool* Values = AttributeMap->getBoolArray(Key, &Count);
+			UpdateHash(Sha, static_cast<uint64>(Count));
+			Sha.Update(reinterpret_cast<const uint8*>(Values), Count * sizeof(bool));
+			break;
+		}
+		case prt::AttributeMap::PT_FLOAT_ARRAY:
+		{
+			const double* Values = AttributeMap->getFloatArray(Key, &Count);
+			UpdateHash(Sha, static_cast<uint64>(Count));
+			Sha.Update(reinterpret_cast<const uint8*>(Values), Count * sizeof(double));
+			break;
+		}
+		case prt::AttributeMap::PT_INT_ARRAY:
+		{
+			const int32_t* Values = AttributeMap->getIntArray(Key, &Count);
+			UpdateHash(Sha, static_cast<uint64>(Count));
+			Sha.Update(reinterpret_cast<const uint8*>(Values), Count * sizeof(int32_t));
+			break;
+		}
+		case prt::AttributeMap::PT_STRING_ARRAY:
+		{
+			wchar_t const* const* Values = AttributeMap->getStringArray(Key, &Count);
+			UpdateHash(Sha, static_cast<uint64>(Count));
+			for (size_t ValueIndex = 0; ValueIndex < Count; ++ValueIndex)
+			{
+				UpdateStringHash(Sha, Values[ValueIndex]);
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+} // namespace
+
+namespace Vitruvio
+{
+FGenerateResultCache::FGenerateResultCache(int64 BudgetBytes) : BudgetBytes(BudgetBytes) {}
+
+FGenerateResultCache::~FGenerateResultCache()
+{
+	Empty();
+}
+
+FSHAHash FGenerateResultCache::ComputeKey(const FGenerateRequest& Request)
+{
+	check(Request.RulePackage);
+
+	FSHA1 Sha;
+	Sha.UpdateWithString(GENERATE_RESULT_CACHE_KEY_VERSION, FCString::Strlen(GENERATE_RESULT_CACHE_KEY_VERSION));
+
+	const FSHAHash RulePackageHash = Request.RulePackage->GetContentHash();
+	Sha.Update(RulePackageHash.Hash, sizeof(RulePackageHash.Hash));
+
+	UpdateHash(Sha, Request.RandomSeed);
+
+	UpdateHash(Sha, Request.InitialShape.Num());
+	for (const FInitialShapeFace& Face : Request.InitialShape)
+	{
+		UpdateHash(Sha, Face.Vertices.Num());
+		Sha.Update(reinterpret_cast<const uint8*>(Face.Vertices.GetData()), Face.Vertices.Num() * sizeof(FVector));
+	}
+
+	UpdateAttributeMapHash(Sha, Request.Attributes.get());
+
+	Sha.Final();
+
+	FSHAHash Key;
+	Sha.GetHash(Key.Hash);
+	return Key;
+}
+
+bool FGenerateResultCache::Find(const FSHAHash& Key, FGenerateResultDescription& OutResult)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	FEntry* Entry = Entries.Find(Key);
+	if (!Entry)
+	{
+		Misses++;
+		return false;
+	}
+
+	Hits++;
+	LruList.RemoveNode(Entry->LruNode, false);
+	LruList.AddHead(Entry->LruNode);
+
+	OutResult = Entry->Result;
+	return true;
+}
+
+void FGenerateResultCache::Add(const FSHAHash& Key, const FGenerateResultDescription& Result)
+{
+	const int64 ResultSize = EstimateResultSize(Result);
+
+	FScopeLock ScopeLock(&Lock);
+
+	Remove(Key);
+
+	// Results larger than the whole budget would evict everything else without ever being hit
+	if (ResultSize > BudgetBytes)
+	{
+		return;
+	}
+
+	while (SizeBytes + ResultSize > BudgetBytes && LruList.GetTail())
+	{
+		Remove(LruList.GetTail()->GetValue());
+		Evictions++;
+	}
+
+	LruList.AddHead(Key);
+
+	FEntry& Entry = Entries.Add(Key);
+	Entry.Result = Result;
+	Entry.SizeBytes = ResultSize;
+	Entry.LruNode = LruList.GetHead();
+
+	SizeBytes += ResultSize;
+}
+
+void FGenerateResultCache::Remove(const FSHAHash& Key)
+{
+	FEntry Entry;
+	if (Entries.RemoveAndCopyValue(Key, Entry))
+	{
+		LruList.RemoveNode(Entry.LruNode);
+		SizeBytes -= Entry.SizeBytes;
+	}
+}
+
+void FGenerateResultCache::Empty()
+{
+	FScopeLock ScopeLock(&Lock);
+
+	Entries.Empty();
+	LruList.Empty();
+	SizeBytes = 0;
+}
+
+FGenerateCacheStats FGenerateResultCache::GetStats() const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	FGenerateCacheStats Stats;
+	Stats.NumEntries = Entries.Num();
+	Stats.SizeBytes = SizeBytes;
+	Stats.BudgetBytes = BudgetBytes;
+	Stats.Hits = Hits;
+	Stats.Misses = Misses;
+	Stats.Evictions = Evictions;
+	return Stats;
+}
+
+int64 EstimateResultSize(const FGenerateResultDescription& Result)
+{
+	// Rough per element sizes of the attributes registered by FStaticMeshAttributes
+	constexpr int64 VertexSize = sizeof(FVector) + 16;
+	constexpr int64 VertexInstanceSize = 2 * sizeof(FVector) + sizeof(float) + sizeof(FVector4) + 8 * sizeof(FVector2D) + 16;
+	constexpr int64 EdgeSize = 2 * sizeof(int32) + sizeof(bool) + sizeof(float) + 16;
+	constexpr int64 TriangleSize = 6 * sizeof(int32) + 16;
+	constexpr int64 PolygonSize = 4 * sizeof(int32) + 32;
+
+	int64 Size = sizeof(FGenerateResultDescription);
+
+	for (const auto& MeshEntry : Result.Meshes)
+	{
+		if (!MeshEntry.Value)
+		{
+			continue;
+		}
+
+		const FMeshDescription& Mesh = MeshEntry.Value->MeshDescription;
+		Size += sizeof(FGeneratedMesh);
+		Size += Mesh.Vertices().Num() * VertexSize;
+		Size += Mesh.VertexInstances().Num() * VertexInstanceSize;
+		Size += Mesh.Edges().Num() * EdgeSize;
+		Size += Mesh.Triangles().Num() * TriangleSize;
+		Size += Mesh.Polygons().Num() * PolygonSize;
+		Size += MeshEntry.Value->Materials.Num() * sizeof(FMaterialAttributeContainer);
+
+		if (MeshEntry.Value->CollisionData)
+		{
+			Size += MeshEntry.Value->CollisionData->Vertices.Num() * sizeof(FVector);
+			Size += MeshEntry.Value->CollisionData->Indices.Num() * sizeof(FTriIndices);
+		}
+	}
+
+	for (const auto& InstanceEntry : Result.Instances)
+	{
+		Size += sizeof(FInstanceCacheKey) + InstanceEntry.Key.MaterialOverrides.Num() * sizeof(FMaterialAttributeContainer);
+		Size += InstanceEntry.Value.Num() * sizeof(FTransform);
+	}
+
+	return Size;
+}
+} // namespace Vitruvio
@@ -0,0 +1,81 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VitruvioModule.h"
+#include "VitruvioTypes.h"
+
+#include "Containers/List.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/SecureHash.h"
+
+namespace Vitruvio
+{
+/**
+ * Least recently used cache of generate results. Results are identified by a content hash of all inputs of a generate call
+ * (initial shape, attributes, random seed and rule package content) and evicted once the memory budget is exceeded.
+ */
+class FGenerateResultCache
+{
+public:
+	explicit FGenerateResultCache(int64 BudgetBytes);
+	~FGenerateResultCache();
+
+	FGenerateResultCache(const FGenerateResultCache&) = delete;
+	FGenerateResultCache& operator=(const FGenerateResultCache&) = delete;
+
+	/** Returns the cache key for the given generate request. */
+	static FSHAHash ComputeKey(const FGenerateRequest& Request);
+
+	/**
+	 * Copies the cached result for Key to OutResult (the generated meshes are shared) and marks it as most recently used. Returns false if
+	 * there is no cached result.
+	 */
+	bool Find(const FSHAHash& Key, FGenerateResultDescription& OutResult);
+
+	/** Adds or replaces the result for Key and evicts least recently used results if the budget is exceeded. */
+	void Add(const FSHAHash& Key, const FGenerateResultDescription& Result);
+
+	void Empty();
+
+	FGenerateCacheStats GetStats() const;
+
+private:
+	struct FEntry
+	{
+		FGenerateResultDescription Result;
+		int64 SizeBytes = 0;
+		TDoubleLinkedList<FSHAHash>::TDoubleLinkedListNode* LruNode = nullptr;
+	};
+
+	void Remove(const FSHAHash& Key);
+
+	mutable FCriticalSection Lock;
+
+	TMap<FSHAHash, FEntry> Entries;
+	// Most recently used key at the head
+	TDoubleLinkedList<FSHAHash> LruList;
+
+	int64 BudgetBytes;
+	int64 SizeBytes = 0;
+	uint64 Hits = 0;
+	uint64 Misses = 0;
+	uint64 Evictions = 0;
+};
+
+/** Returns an estimate of the memory used by the given generate result. */
+int64 EstimateResultSize(const FGenerateResultDescription& Result);
+} // namespace Vitruvio
@@ -0,0 +1,387 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GenerateResultDiskCache.h"
+
+#include "Algo/Sort.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/CustomVersion.h"
+#include "Serialization/LargeMemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/ObjectVersion.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGenerateResultDiskCache, Log, All);
+
+namespace
+{
+constexpr uint32 FILE_MAGIC = 0x43524756; // "VGRC"
+
+// Has to be increased whenever the file layout below changes
+enum class EFileVersion : int32
+{
+	Initial = 1,
+	SharedMeshes,
+	PersistentRulePackageDirectory,
+
+	VersionPlusOne,
+	Latest = VersionPlusOne - 1
+};
+
+const TCHAR* FILE_EXTENSION = TEXT(".vgr");
+const TCHAR* RULE_PACKAGE_DIRECTORY_TOKEN = TEXT("{RulePackageDirectory}");
+
+template <typename FunctionType>
+void TransformTexturePaths(TArray<Vitruvio::FMaterialAttributeContainer>& Materials, FunctionType Function)
+{
+	for (Vitruvio::FMaterialAttributeContainer& Material : Materials)
+	{
+		for (auto& TextureProperty : Material.TextureProperties)
+		{
+			Function(TextureProperty.Value);
+		}
+	}
+}
+
+template <typename FunctionType>
+void TransformTexturePaths(Vitruvio::FInstanceMap& Instances, FunctionType Function)
+{
+	// The instance overrides are part of the map keys, the map therefore has to be rebuilt
+	Vitruvio::FInstanceMap TransformedInstances;
+	for (auto& InstanceEntry : Instances)
+	{
+		Vitruvio::FInstanceCacheKey Key = InstanceEntry.Key;
+		TransformTexturePaths(Key.MaterialOverrides, Function);
+		TransformedInstances.Add(MoveTemp(Key), MoveTemp(InstanceEntry.Value));
+	}
+	Instances = MoveTemp(TransformedInstances);
+}
+
+/*
+ * File layout:
+ *   uint32 magic, int32 file version, int32 package version (UE4), custom versions of the payload, payload
+ * The payload contains the meshes (prototype id, mesh description and materials) and instances of a single FGenerateResultDescription.
+ * Collision data is not stored but recreated from the mesh descriptions.
+ */
+template <typename FunctionType>
+void SavePayload(FArchive& Ar, const FGenerateResultDescription& Result, FunctionType MakePortable)
+{
+	int32 NumMeshes = Result.Meshes.Num();
+	Ar << NumMeshes;
+	for (const auto& MeshEntry : Result.Meshes)
+	{
+		int32 PrototypeId = MeshEntry.Key;
+		Ar << PrototypeId;
+
+		// Saving does not modify the mesh description
+		const_cast<FMeshDescription&>(MeshEntry.Value->MeshDescription).Serialize(Ar);
+
+		TArray<Vitruvio::FMaterialAttributeContainer> Materials = MeshEntry.Value->Materials;
+		TransformTexturePaths(Materials, MakePortable);
+		Ar << Materials;
+	}
+
+	Vitruvio::FInstanceMap Instances = Result.Instances;
+	TransformTexturePaths(Instances, MakePortable);
+	Ar << Instances;
+}
+
+template <typename FunctionType>
+void LoadPayload(FArchive& Ar, FGenerateResultDescription& Result, FunctionType ResolvePortable)
+{
+	int32 NumMeshes = 0;
+	Ar << NumMeshes;
+	for (int32 MeshIndex = 0; MeshIndex < NumMeshes && !Ar.IsError(); ++MeshIndex)
+	{
+		int32 PrototypeId;
+		Ar << PrototypeId;
+
+		const TSharedRef<Vitruvio::FGeneratedMesh, ESPMode::ThreadSafe> Mesh = MakeShared<Vitruvio::FGeneratedMesh, ESPMode::ThreadSafe>();
+		Mesh->MeshDescription.Serialize(Ar);
+		Ar << Mesh->Materials;
+		TransformTexturePaths(Mesh->Materials, ResolvePortable);
+		Mesh->CollisionData = MakeShared<const Vitruvio::FCollisionData, ESPMode::ThreadSafe>(Vitruvio::CreateCollisionData(Mesh->MeshDescription));
+		Mesh->ContentHash = Vitruvio::ComputeMeshContentHash(Mesh->MeshDescription, Mesh->Materials);
+
+		Result.Meshes.Add(PrototypeId, Mesh);
+	}
+
+	Ar << Result.Instances;
+	TransformTexturePaths(Result.Instances, ResolvePortable);
+}
+
+struct FMappedFile
+{
+	TUniquePtr<IMappedFileHandle> Handle;
+	TUniquePtr<IMappedFileRegion> Region;
+	TArray<uint8> FallbackData;
+
+	const uint8* GetData() const
+	{
+		return Region ? Region->GetMappedPtr() : FallbackData.GetData();
+	}
+
+	int64 GetSize() const
+	{
+		return Region ? Region->GetMappedSize() : FallbackData.Num();
+	}
+};
+
+bool MapFile(const FString& Path, FMappedFile& OutFile)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.FileExists(*Path))
+	{
+		return false;
+	}
+
+	OutFile.Handle.Reset(PlatformFile.OpenMapped(*Path));
+	if (OutFile.Handle)
+	{
+		OutFile.Region.Reset(OutFile.Handle->MapRegion());
+	}
+
+	// Memory mapping is not supported on all platforms
+	if (!OutFile.Region)
+	{
+		OutFile.Handle.Reset();
+		return FFileHelper::LoadFileToArray(OutFile.FallbackData, *Path, FILEREAD_Silent);
+	}
+
+	return true;
+}
+} // namespace
+
+namespace Vitruvio
+{
+FGenerateResultDiskCache::FGenerateResultDiskCache(const FString& Directory, const FString& InRulePackageDirectory, int64 BudgetBytes)
+	: Directory(Directory), RulePackageDirectory(InRulePackageDirectory), BudgetBytes(BudgetBytes)
+{
+	FPaths::NormalizeDirectoryName(RulePackageDirectory);
+	IFileManager::Get().MakeDirectory(*Directory, true);
+	AddEntries();
+}
+
+FGenerateResultDiskCache::~FGenerateResultDiskCache()
+{
+	FGenericPlatformProcess::ConditionalSleep([this]() { return NumPendingSaves.GetValue() == 0; }, 0);
+}
+
+void FGenerateResultDiskCache::AddEntries()
+{
+	IFileManager& FileManager = IFileManager::Get();
+	TArray<FString> IncompleteFiles;
+
+	FileManager.IterateDirectoryStatRecursively(*Directory, [&](const TCHAR* Path, const FFileStatData& StatData) {
+		if (StatData.bIsDirectory || FPaths::GetExtension(Path, true) != FILE_EXTENSION)
+		{
+			return true;
+		}
+
+		const FString KeyString = FPaths::GetBaseFilename(Path);
+		if (KeyString.Len() != 40)
+		{
+			// Remainders of writes which have been interrupted, eg. by closing the editor
+			IncompleteFiles.Add(Path);
+			return true;
+		}
+
+		FSHAHash Key;
+		Key.FromString(KeyString);
+		Entries.Add(Key, {StatData.FileSize, StatData.ModificationTime});
+		TotalSizeBytes += StatData.FileSize;
+		return true;
+	});
+
+	for (const FString& Path : IncompleteFiles)
+	{
+		FileManager.Delete(*Path, false, true, true);
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	EvictLeastRecentlyUsed();
+}
+
+FString FGenerateResultDiskCache::GetFilePath(const FSHAHash& Key) const
+{
+	const FString KeyString = Key.ToString();
+	// Distribute the files to subdirectories to keep the number of files per directory small
+	return FPaths::Combine(Directory, KeyString.Left(2), KeyString + FILE_EXTENSION);
+}
+
+bool FGenerateResultDiskCache::Load(const FSHAHash& Key, FGenerateResultDescription& OutResult)
+{
+	const FString Path = GetFilePath(Key);
+
+	FMappedFile File;
+	if (!MapFile(Path, File))
+	{
+		return false;
+	}
+
+	FLargeMemoryReader Reader(File.GetData(), File.GetSize(), ELargeMemoryReaderFlags::None, FName(*Path));
+
+	uint32 Magic = 0;
+	int32 FileVersion = 0;
+	int32 PackageVersion = 0;
+	Reader << Magic;
+	Reader << FileVersion;
+	Reader << PackageVersion;
+
+	if (Reader.IsError() || Magic != FILE_MAGIC || FileVersion != static_cast<int32>(EFileVersion::Latest) ||
+		PackageVersion != GPackageFileUE4Version)
+	{
+		UE_LOG(LogGenerateResultDiskCache, Verbose, TEXT("Ignoring outdated cached result %s"), *Path)
+		return false;
+	}
+
+	FCustomVersionContainer CustomVersions;
+	CustomVersions.Serialize(Reader);
+	Reader.SetCustomVersions(CustomVersions);
+
+	FGenerateResultDescription Result;
+	LoadPayload(Reader, Result, [this](FString& TexturePath) {
+		if (TexturePath.StartsWith(RULE_PACKAGE_DIRECTORY_TOKEN))
+		{
+			TexturePath = RulePackageDirectory + TexturePath.RightChop(FCString::Strlen(RULE_PACKAGE_DIRECTORY_TOKEN));
+		}
+	});
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogGenerateResultDiskCache, Warning, TEXT("Could not read cached result %s"), *Path)
+		return false;
+	}
+
+	OutResult = MoveTemp(Result);
+
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (FEntry* Entry = Entries.Find(Key))
+		{
+			Entry->LastUsed = FDateTime::UtcNow();
+		}
+	}
+	// The time stamp of the file is used to find the least recently used results in later sessions
+	IFileManager::Get().SetTimeStamp(*Path, FDateTime::UtcNow());
+
+	return true;
+}
+
+void FGenerateResultDiskCache::SaveAsync(const FSHAHash& Key, FGenerateResultDescription Result)
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (Entries.Contains(Key) || PendingSaves.Contains(Key))
+		{
+			return;
+		}
+		PendingSaves.Add(Key);
+	}
+
+	// Writing is kept off the generate threads. Meshes are shared and never modified once generated, the result can therefore be written
+	// while it is being applied.
+	NumPendingSaves.Increment();
+	Async(EAsyncExecution::ThreadPool, [this, Key, Result = MoveTemp(Result)]() {
+		const int64 SizeBytes = Save(Key, Result);
+
+		FScopeLock ScopeLock(&Lock);
+		PendingSaves.Remove(Key);
+		if (SizeBytes != INDEX_NONE)
+		{
+			Entries.Add(Key, {SizeBytes, FDateTime::UtcNow()});
+			TotalSizeBytes += SizeBytes;
+			EvictLeastRecentlyUsed();
+		}
+		NumPendingSaves.Decrement();
+	});
+}
+
+void FGenerateResultDiskCache::EvictLeastRecentlyUsed()
+{
+	if (TotalSizeBytes <= BudgetBytes)
+	{
+		return;
+	}
+
+	TArray<TPair<FSHAHash, FEntry>> SortedEntries = Entries.Array();
+	Algo::SortBy(SortedEntries, [](const TPair<FSHAHash, FEntry>& Entry) { return Entry.Value.LastUsed; });
+
+	for (const TPair<FSHAHash, FEntry>& Entry : SortedEntries)
+	{
+		if (TotalSizeBytes <= BudgetBytes)
+		{
+			break;
+		}
+
+		IFileManager::Get().Delete(*GetFilePath(Entry.Key), false, true, true);
+		Entries.Remove(Entry.Key);
+		TotalSizeBytes -= Entry.Value.SizeBytes;
+	}
+}
+
+int64 FGenerateResultDiskCache::Save(const FSHAHash& Key, const FGenerateResultDescription& Result) const
+{
+	// The payload is written first since we only know its custom versions afterwards
+	TArray<uint8> Payload;
+	FMemoryWriter PayloadWriter(Payload, true);
+	SavePayload(PayloadWriter, Result, [this](FString& TexturePath) {
+		FString NormalizedPath = TexturePath;
+		FPaths::NormalizeFilename(NormalizedPath);
+		if (NormalizedPath.StartsWith(RulePackageDirectory + TEXT("/")))
+		{
+			TexturePath = RULE_PACKAGE_DIRECTORY_TOKEN + NormalizedPath.RightChop(RulePackageDirectory.Len());
+		}
+	});
+
+	TArray<uint8> FileData;
+	FMemoryWriter Writer(FileData, true);
+
+	uint32 Magic = FILE_MAGIC;
+	int32 FileVersion = static_cast<int32>(EFileVersion::Latest);
+	int32 PackageVersion = GPackageFileUE4Version;
+	Writer << Magic;
+	Writer << FileVersion;
+	Writer << PackageVersion;
+
+	FCustomVersionContainer CustomVersions = PayloadWriter.GetCustomVersions();
+	CustomVersions.Serialize(Writer);
+
+	Writer.Serialize(Payload.GetData(), Payload.Num());
+
+	// Write to a temporary file first so that concurrent readers never see a partially written file
+	const FString Path = GetFilePath(Key);
+	const FString TempPath = FPaths::CreateTempFilename(*FPaths::GetPath(Path), TEXT("Temp_"), FILE_EXTENSION);
+	if (!FFileHelper::SaveArrayToFile(FileData, *TempPath) || !IFileManager::Get().Move(*Path, *TempPath, true, true, false, true))
+	{
+		UE_LOG(LogGenerateResultDiskCache, Warning, TEXT("Could not write cached result %s"), *Path)
+		IFileManager::Get().Delete(*TempPath, false, true, true);
+		return INDEX_NONE;
+	}
+	return FileData.Num();
+}
+
+void FGenerateResultDiskCache::Empty()
+{
+	FScopeLock ScopeLock(&Lock);
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+	IFileManager::Get().MakeDirectory(*Directory, true);
+	Entries.Empty();
+	TotalSizeBytes = 0;
+}
+} // namespace Vitruvio
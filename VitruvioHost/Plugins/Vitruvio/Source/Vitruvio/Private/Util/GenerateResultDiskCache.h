@@ -0,0 +1,78 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VitruvioModule.h"
+
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Misc/SecureHash.h"
+
+namespace Vitruvio
+{
+/**
+ * Persists generate results across editor sessions. Every result is stored in a versioned binary file named after its cache key
+ * (see FGenerateResultCache::ComputeKey) and memory-mapped when loaded.
+ *
+ * Texture paths below the rule package unpack directory are stored relative to it so that the cache stays valid if the project is moved.
+ *
+ * Results are written in the background. The least recently used results are deleted once the total size of the stored results exceeds
+ * the budget.
+ */
+class FGenerateResultDiskCache
+{
+public:
+	FGenerateResultDiskCache(const FString& Directory, const FString& RulePackageDirectory, int64 BudgetBytes);
+
+	/** Waits for the results which are still being written. */
+	~FGenerateResultDiskCache();
+
+	/** Loads the result stored for Key. Returns false if there is no result or it was written by an incompatible version. */
+	bool Load(const FSHAHash& Key, FGenerateResultDescription& OutResult);
+
+	/** Stores the result for Key in the background. Results which are already stored (or being stored) are not written again. */
+	void SaveAsync(const FSHAHash& Key, FGenerateResultDescription Result);
+
+	/** Deletes all stored results. */
+	void Empty();
+
+private:
+	struct FEntry
+	{
+		int64 SizeBytes;
+		FDateTime LastUsed;
+	};
+
+	FString GetFilePath(const FSHAHash& Key) const;
+
+	/** Returns the size of the written file or INDEX_NONE if writing failed. */
+	int64 Save(const FSHAHash& Key, const FGenerateResultDescription& Result) const;
+
+	void AddEntries();
+	void EvictLeastRecentlyUsed();
+
+	FString Directory;
+	FString RulePackageDirectory;
+	int64 BudgetBytes;
+
+	FCriticalSection Lock;
+	TMap<FSHAHash, FEntry> Entries;
+	TSet<FSHAHash> PendingSaves;
+	int64 TotalSizeBytes = 0;
+
+	FThreadSafeCounter NumPendingSaves;
+};
+} // namespace Vitruvio
@@ -0,0 +1,124 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GenerateThreadPool.h"
+
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+// PRT can recurse deeply for complex rules so we use the same stack size as for regular threads
+constexpr uint32 GENERATE_THREAD_STACK_SIZE = 1024 * 1024;
+} // namespace
+
+namespace Vitruvio
+{
+class FGenerateThreadPool::FWork final : public IQueuedWork
+{
+	FGenerateThreadPool& Pool;
+
+public:
+	explicit FWork(FGenerateThreadPool& Pool) : Pool(Pool) {}
+
+	void DoThreadedWork() override
+	{
+		Pool.ExecuteNext();
+		delete this;
+	}
+
+	void Abandon() override
+	{
+		// Still execute the job so that all promises are fulfilled
+		Pool.ExecuteNext();
+		delete this;
+	}
+};
+
+FGenerateThreadPool::FGenerateThreadPool(int32 InNumThreads, const TCHAR* Name) : NumThreads(InNumThreads)
+{
+	ThreadPool = FQueuedThreadPool::Allocate();
+	verify(ThreadPool->Create(NumThreads, GENERATE_THREAD_STACK_SIZE, TPri_Normal, Name));
+}
+
+FGenerateThreadPool::~FGenerateThreadPool()
+{
+	ThreadPool->Destroy();
+	delete ThreadPool;
+}
+
+void FGenerateThreadPool::Enqueue(TUniqueFunction<void()> Function, EGeneratePriority Priority)
+{
+	{
+		FScopeLock Lock(&QueueLock);
+		Queues[static_cast<int32>(Priority)].Enqueue({MoveTemp(Function), FPlatformTime::Seconds()});
+		QueueDepth++;
+	}
+
+	// Every work item executes the job with the highest priority at the time it is started and not necessarily the one it was created for
+	ThreadPool->AddQueuedWork(new FWork(*this));
+}
+
+void FGenerateThreadPool::ExecuteNext()
+{
+	FJob Job;
+	{
+		FScopeLock Lock(&QueueLock);
+		bool bFound = false;
+		for (TQueue<FJob>& Queue : Queues)
+		{
+			if (Queue.Dequeue(Job))
+			{
+				bFound = true;
+				break;
+			}
+		}
+
+		if (!bFound)
+		{
+			return;
+		}
+
+		const double WaitTime = FPlatformTime::Seconds() - Job.EnqueueTime;
+		TotalWaitTime += WaitTime;
+		MaxWaitTime = FMath::Max(MaxWaitTime, WaitTime);
+		QueueDepth--;
+		ActiveJobs++;
+	}
+
+	Job.Function();
+
+	{
+		FScopeLock Lock(&QueueLock);
+		ActiveJobs--;
+		CompletedJobs++;
+	}
+}
+
+FGenerateQueueStats FGenerateThreadPool::GetStats() const
+{
+	FScopeLock Lock(&QueueLock);
+
+	FGenerateQueueStats Stats;
+	Stats.NumThreads = NumThreads;
+	Stats.QueueDepth = QueueDepth;
+	Stats.ActiveJobs = ActiveJobs;
+	Stats.CompletedJobs = CompletedJobs;
+	const uint64 StartedJobs = CompletedJobs + ActiveJobs;
+	Stats.AverageWaitTime = StartedJobs > 0 ? TotalWaitTime / StartedJobs : 0;
+	Stats.MaxWaitTime = MaxWaitTime;
+	return Stats;
+}
+} // namespace Vitruvio
@@ -0,0 +1,75 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VitruvioTypes.h"
+
+#include "Async/Future.h"
+#include "Containers/Queue.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/QueuedThreadPool.h"
+#include "Templates/Function.h"
+
+namespace Vitruvio
+{
+/**
+ * Bounded pool of worker threads used for PRT calls. Jobs are executed in order of their priority and in FIFO order within the same
+ * priority.
+ */
+class FGenerateThreadPool
+{
+public:
+	FGenerateThreadPool(int32 NumThreads, const TCHAR* Name);
+	~FGenerateThreadPool();
+
+	FGenerateThreadPool(const FGenerateThreadPool&) = delete;
+	FGenerateThreadPool& operator=(const FGenerateThreadPool&) = delete;
+
+	template <typename ResultType>
+	TFuture<ResultType> Execute(TUniqueFunction<ResultType()> Function, EGeneratePriority Priority = EGeneratePriority::Normal)
+	{
+		TSharedRef<TPromise<ResultType>, ESPMode::ThreadSafe> Promise = MakeShared<TPromise<ResultType>, ESPMode::ThreadSafe>();
+		TFuture<ResultType> Future = Promise->GetFuture();
+		Enqueue([Promise, Function = MoveTemp(Function)]() { Promise->SetValue(Function()); }, Priority);
+		return Future;
+	}
+
+	FGenerateQueueStats GetStats() const;
+
+private:
+	class FWork;
+
+	struct FJob
+	{
+		TUniqueFunction<void()> Function;
+		double EnqueueTime = 0;
+	};
+
+	void Enqueue(TUniqueFunction<void()> Function, EGeneratePriority Priority);
+	void ExecuteNext();
+
+	FQueuedThreadPool* ThreadPool = nullptr;
+	int32 NumThreads = 0;
+
+	mutable FCriticalSection QueueLock;
+	TQueue<FJob> Queues[static_cast<int32>(EGeneratePriority::Num)];
+	int32 QueueDepth = 0;
+	int32 ActiveJobs = 0;
+	uint64 CompletedJobs = 0;
+	double TotalWaitTime = 0;
+	double MaxWaitTime = 0;
+};
+} // namespace Vitruvio
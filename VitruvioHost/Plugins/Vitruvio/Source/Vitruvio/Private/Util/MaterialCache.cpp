@@ -0,0 +1,128 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MaterialCache.h"
+
+#include "TextureCache.h"
+
+#include "Materials/MaterialInstanceDynamic.h"
+
+namespace Vitruvio
+{
+FMaterialCache::FMaterialCache(int32 MaxUnusedMaterials, FTextureCache& TextureCache)
+	: MaxUnusedMaterials(FMath::Max(0, MaxUnusedMaterials)), TextureCache(TextureCache)
+{
+}
+
+FMaterialCache::~FMaterialCache() = default;
+
+UMaterialInstanceDynamic* FMaterialCache::Acquire(const FMaterialAttributeContainer& MaterialAttributes)
+{
+	check(IsInGameThread());
+
+	FEntry* Entry = Entries.Find(MaterialAttributes);
+	if (!Entry)
+	{
+		++Misses;
+		return nullptr;
+	}
+
+	++Hits;
+	if (Entry->UnusedNode)
+	{
+		UnusedList.RemoveNode(Entry->UnusedNode);
+		Entry->UnusedNode = nullptr;
+	}
+	++Entry->NumReferences;
+	return Entry->Material;
+}
+
+void FMaterialCache::Add(const FMaterialAttributeContainer& MaterialAttributes, UMaterialInstanceDynamic* Material)
+{
+	check(IsInGameThread());
+	check(Material && !Entries.Contains(MaterialAttributes));
+
+	FEntry& Entry = Entries.Add(MaterialAttributes);
+	Entry.Material = Material;
+	Entry.NumReferences = 1;
+	MaterialAttributesByMaterial.Add(Material, MaterialAttributes);
+}
+
+void FMaterialCache::Release(UMaterialInterface* Material)
+{
+	check(IsInGameThread());
+
+	const FMaterialAttributeContainer* MaterialAttributes = MaterialAttributesByMaterial.Find(Material);
+	if (!MaterialAttributes)
+	{
+		return;
+	}
+
+	FEntry& Entry = Entries.FindChecked(*MaterialAttributes);
+	check(Entry.NumReferences > 0);
+	if (--Entry.NumReferences == 0)
+	{
+		UnusedList.AddHead(Entry.Material);
+		Entry.UnusedNode = UnusedList.GetHead();
+		EvictUnused();
+	}
+}
+
+void FMaterialCache::EvictUnused()
+{
+	while (UnusedList.Num() > MaxUnusedMaterials)
+	{
+		TDoubleLinkedList<UMaterialInstanceDynamic*>::TDoubleLinkedListNode* Node = UnusedList.GetTail();
+		UMaterialInstanceDynamic* Material = Node->GetValue();
+		UnusedList.RemoveNode(Node);
+
+		const FMaterialAttributeContainer MaterialAttributes = MaterialAttributesByMaterial.FindAndRemoveChecked(Material);
+		Entries.Remove(MaterialAttributes);
+		++Evictions;
+
+		// Every texture property has acquired a texture when the material has been created
+		for (const auto& TextureProperty : MaterialAttributes.TextureProperties)
+		{
+			TextureCache.Release(TextureProperty.Value);
+		}
+	}
+}
+
+FMaterialCacheStats FMaterialCache::GetStats() const
+{
+	check(IsInGameThread());
+
+	FMaterialCacheStats Stats;
+	Stats.NumMaterials = Entries.Num();
+	Stats.NumUnused = UnusedList.Num();
+	Stats.MaxUnused = MaxUnusedMaterials;
+	Stats.Hits = Hits;
+	Stats.Misses = Misses;
+	Stats.Evictions = Evictions;
+	for (const auto& AttributesAndEntry : Entries)
+	{
+		Stats.SizeBytes += AttributesAndEntry.Value.Material->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	}
+	return Stats;
+}
+
+void FMaterialCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (auto& AttributesAndEntry : Entries)
+	{
+		Collector.AddReferencedObject(AttributesAndEntry.Value.Material);
+	}
+}
+} // namespace Vitruvio
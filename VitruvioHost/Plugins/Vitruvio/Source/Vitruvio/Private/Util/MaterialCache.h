@@ -0,0 +1,92 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VitruvioTypes.h"
+
+#include "Containers/List.h"
+#include "CoreMinimal.h"
+
+class UMaterialInterface;
+class UMaterialInstanceDynamic;
+
+namespace Vitruvio
+{
+class FTextureCache;
+
+/**
+ * Cache of the material instances created for generated models, identified by their material attributes. Materials are reference
+ * counted by the generated models (the shared static meshes and the instance override materials) which use them. Materials which are
+ * not used anymore are kept for later reuse until more than the configured number of unused materials exist, then the least recently
+ * used ones are evicted.
+ *
+ * The cache must only be used from the game thread.
+ */
+class FMaterialCache
+{
+public:
+	/** The textures of evicted materials are released from the given texture cache. */
+	FMaterialCache(int32 MaxUnusedMaterials, FTextureCache& TextureCache);
+	~FMaterialCache();
+
+	FMaterialCache(const FMaterialCache&) = delete;
+	FMaterialCache& operator=(const FMaterialCache&) = delete;
+
+	/** Returns the cached material for the given attributes and acquires a reference to it, or nullptr if there is no such material. */
+	UMaterialInstanceDynamic* Acquire(const FMaterialAttributeContainer& MaterialAttributes);
+
+	/** Returns whether a material for the given attributes is cached, without acquiring a reference to it. */
+	bool Contains(const FMaterialAttributeContainer& MaterialAttributes) const
+	{
+		return Entries.Contains(MaterialAttributes);
+	}
+
+	/** Adds a newly created material with one reference. */
+	void Add(const FMaterialAttributeContainer& MaterialAttributes, UMaterialInstanceDynamic* Material);
+
+	/** Releases a reference acquired by Acquire or Add. Materials which are not in the cache are ignored. */
+	void Release(UMaterialInterface* Material);
+
+	FMaterialCacheStats GetStats() const;
+
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
+private:
+	struct FEntry
+	{
+		UMaterialInstanceDynamic* Material = nullptr;
+		int32 NumReferences = 0;
+
+		// Only set while the material is unused
+		TDoubleLinkedList<UMaterialInstanceDynamic*>::TDoubleLinkedListNode* UnusedNode = nullptr;
+	};
+
+	void EvictUnused();
+
+	TMap<FMaterialAttributeContainer, FEntry> Entries;
+	TMap<UMaterialInterface*, FMaterialAttributeContainer> MaterialAttributesByMaterial;
+
+	// Most recently released material at the head
+	TDoubleLinkedList<UMaterialInstanceDynamic*> UnusedList;
+
+	int32 MaxUnusedMaterials;
+	FTextureCache& TextureCache;
+
+	uint64 Hits = 0;
+	uint64 Misses = 0;
+	uint64 Evictions = 0;
+};
+} // namespace Vitruvio
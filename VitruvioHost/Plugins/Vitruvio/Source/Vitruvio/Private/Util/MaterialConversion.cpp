@@ -24,6 +24,10 @@
 #include "IImageWrapperModule.h"
 #include "ImageChannelsDetection.h"
 #include "ImageCore/Public/ImageCore.h"
+#include "OpacityMapClassification.h"
+#include "RHI.h"
+#include "TextureCache.h"
+#include "TextureCompression.h"
 #include "VitruvioTypes.h"
 
 #include <map>
@@ -33,8 +37,6 @@ DEFINE_LOG_CATEGORY(LogMaterialConversion);
 namespace
 {
 
-constexpr double BLACK_COLOR_THRESHOLD = 0.02;
-constexpr double WHITE_COLOR_THRESHOLD = 1.0 - BLACK_COLOR_THRESHOLD;
 constexpr double OPACITY_THRESHOLD = 0.98;
 
 const FString CE_DEFAULT_SHADER_NAME = TEXT("CityEngineShader");
@@ -46,47 +48,6 @@ struct FTextureSettings
 	TextureCompressionSettings Compression;
 };
 
-template <typename T, typename F>
-void CountOpacityMapPixels(const T* SrcColors, int32 SizeX, int32 SizeY, uint32& BlackPixels, uint32& WhitePixels, F Accessor)
-{
-	BlackPixels = 0;
-	WhitePixels = 0;
-
-	const T* LastColor = SrcColors + (SizeX * SizeY);
-	while (SrcColors < LastColor)
-	{
-		const float Value = Accessor(SrcColors);
-
-		if (Value < BLACK_COLOR_THRESHOLD)
-		{
-			BlackPixels++;
-		}
-		else if (Value > WHITE_COLOR_THRESHOLD)
-		{
-			WhitePixels++;
-		}
-		++SrcColors;
-	}
-}
-
-void CountOpacityMapPixels(const FColor* SrcColors, bool UseAlphaChannel, int32 SizeX, int32 SizeY, uint32& BlackPixels, uint32& WhitePixels)
-{
-	return CountOpacityMapPixels(SrcColors, SizeX, SizeY, BlackPixels, WhitePixels,
-								 [UseAlphaChannel](const FColor* Color) { return static_cast<float>(UseAlphaChannel ? Color->A : Color->R) / 0xFF; });
-}
-
-void CountOpacityMapPixels(const uint8* SrcColors, int32 SizeX, int32 SizeY, uint32& BlackPixels, uint32& WhitePixels)
-{
-	return CountOpacityMapPixels(SrcColors, SizeX, SizeY, BlackPixels, WhitePixels,
-								 [](const uint8* Color) { return static_cast<float>(*Color) / 0xFF; });
-}
-
-void CountOpacityMapPixels(const uint16* SrcColors, int32 SizeX, int32 SizeY, uint32& BlackPixels, uint32& WhitePixels)
-{
-	return CountOpacityMapPixels(SrcColors, SizeX, SizeY, BlackPixels, WhitePixels,
-								 [](const uint16* Color) { return static_cast<float>(*Color) / 0xFFFF; });
-}
-
 ERGBFormat GetRequestedFormat(ERGBFormat Format)
 {
 	// We handle textures similarly to Unreal handles non power of two images (which will not be DXT compressed) and always use
@@ -130,12 +91,44 @@ FTextureSettings GetTextureSettings(const FString& Key, ERGBFormat Format)
 	return {Format == ERGBFormat::Gray ? false : true, TC_Default};
 }
 
+EPixelFormat GetCompressedPixelFormat(TextureCompressionSettings Compression, bool bHasAlpha)
+{
+	switch (Compression)
+	{
+	case TC_Normalmap:
+		return PF_BC5;
+	case TC_Masks:
+		// Roughness and metallic are read from the G and B channels (glTF convention), BC4 would only keep R
+		return PF_DXT1;
+	default:
+		return bHasAlpha ? PF_DXT5 : PF_DXT1;
+	}
+}
+
+void AddMip(UTexture2D* Texture, int32 SizeX, int32 SizeY, const void* Data, int64 NumBytes)
+{
+	FTexture2DMipMap* Mip = new FTexture2DMipMap();
+	Texture->PlatformData->Mips.Add(Mip);
+	Mip->SizeX = SizeX;
+	Mip->SizeY = SizeY;
+	Mip->BulkData.Lock(LOCK_READ_WRITE);
+	void* TextureData = Mip->BulkData.Realloc(CalculateImageBytes(SizeX, SizeY, 0, Texture->PlatformData->PixelFormat));
+	FMemory::Memcpy(TextureData, Data, NumBytes);
+	Mip->BulkData.Unlock();
+}
+
 UTexture2D* CreateTexture(UObject* OuterObjectName, const TArray64<uint8>& Data, int32 SizeX, int32 SizeY, ERGBFormat Format, int32 BitDepth,
-						  const FString& TextureKey, const FName& BaseName)
+						  bool bHasAlpha, const FString& TextureKey, const FName& BaseName)
 {
-	const EPixelFormat PixelFormat = PixelFormatFromRGB(Format, BitDepth);
+	const EPixelFormat UncompressedPixelFormat = PixelFormatFromRGB(Format, BitDepth);
 	const FTextureSettings Settings = GetTextureSettings(TextureKey, Format);
 
+	// 8 bit images get a full mip chain and are block compressed if the RHI supports the format, otherwise a single uncompressed mip is used
+	const EPixelFormat CompressedPixelFormat = GetCompressedPixelFormat(Settings.Compression, bHasAlpha);
+	const bool bCompress = UncompressedPixelFormat == PF_B8G8R8A8 && Data.Num() == static_cast<int64>(SizeX) * SizeY * sizeof(FColor) &&
+						   Vitruvio::CanBlockCompress(SizeX, SizeY) && GPixelFormats[CompressedPixelFormat].Supported;
+	const EPixelFormat PixelFormat = bCompress ? CompressedPixelFormat : UncompressedPixelFormat;
+
 	const FName TextureName = MakeUniqueObjectName(GetTransientPackage(), UTexture2D::StaticClass(), BaseName);
 	UTexture2D* NewTexture = NewObject<UTexture2D>(GetTransientPackage(), TextureName, RF_Transient);
 
@@ -146,118 +139,77 @@ UTexture2D* CreateTexture(UObject* OuterObjectName, const TArray64<uint8>& Data,
 	NewTexture->CompressionSettings = Settings.Compression;
 	NewTexture->SRGB = Settings.SRGB;
 
-	// Allocate first mipmap and upload the pixel data
-	FTexture2DMipMap* Mip = new FTexture2DMipMap();
-	NewTexture->PlatformData->Mips.Add(Mip);
-	Mip->SizeX = SizeX;
-	Mip->SizeY = SizeY;
-	Mip->BulkData.Lock(LOCK_READ_WRITE);
-	void* TextureData = Mip->BulkData.Realloc(CalculateImageBytes(SizeX, SizeY, 0, PixelFormat));
-	FMemory::Memcpy(TextureData, Data.GetData(), Data.Num());
-	Mip->BulkData.Unlock();
-
-	NewTexture->UpdateResource();
-	return NewTexture;
-}
-
-Vitruvio::FTextureData LoadTextureFromDisk(UObject* Outer, const FString& ImagePath, const FString& TextureKey)
-{
-	static IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
-
-	if (!FPaths::FileExists(ImagePath))
+	if (bCompress)
 	{
-		UE_LOG(LogMaterialConversion, Error, TEXT("File not found: %s"), *ImagePath);
-		return {};
-	}
+		// The mips only live in memory, all of them have to be resident
+		NewTexture->NeverStream = true;
 
-	TArray<uint8> FileData;
-	if (!FFileHelper::LoadFileToArray(FileData, *ImagePath))
-	{
-		UE_LOG(LogMaterialConversion, Error, TEXT("Failed to load file: %s"), *ImagePath);
-		return {};
-	}
-	const EImageFormat ImageFormat = ImageWrapperModule.DetectImageFormat(FileData.GetData(), FileData.Num());
-	if (ImageFormat == EImageFormat::Invalid)
-	{
-		UE_LOG(LogMaterialConversion, Error, TEXT("Unrecognized image file format: %s"), *ImagePath);
-		return {};
+		const TArray<TArray<FColor>> Mips =
+			Vitruvio::GenerateMipChain(reinterpret_cast<const FColor*>(Data.GetData()), SizeX, SizeY, Settings.SRGB);
+		for (int32 MipIndex = 0; MipIndex < Mips.Num(); ++MipIndex)
+		{
+			const int32 MipSizeX = FMath::Max(1, SizeX >> MipIndex);
+			const int32 MipSizeY = FMath::Max(1, SizeY >> MipIndex);
+			const TArray<uint8> Compressed = Vitruvio::CompressImage(Mips[MipIndex].GetData(), MipSizeX, MipSizeY, PixelFormat);
+			AddMip(NewTexture, MipSizeX, MipSizeY, Compressed.GetData(), Compressed.Num());
+		}
 	}
-
-	TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(ImageFormat);
-
-	if (!ImageWrapper.IsValid())
+	else
 	{
-		UE_LOG(LogMaterialConversion, Error, TEXT("Failed to create image wrapper for file: %s"), *ImagePath);
-		return {};
+		AddMip(NewTexture, SizeX, SizeY, Data.GetData(), Data.Num());
 	}
 
-	// Unfortunately using the IImageWrapperModule to load textures will always result in images with alpha channels even if
-	// the original texture does not contain an alpha channel. Since we have to check the existence of alpha channels to determine
-	// the blend mode we need to extract real number of channels manually.
-	const uint32 NumChannels = Vitruvio::DetectChannels(ImageFormat, FileData.GetData(), FileData.Num());
-
-	// Decompress the image data
-	TArray64<uint8> RawData;
-	ImageWrapper->SetCompressed(FileData.GetData(), FileData.Num());
-	const ERGBFormat Format = GetRequestedFormat(ImageWrapper->GetFormat());
-	ImageWrapper->GetRaw(Format, ImageWrapper->GetBitDepth(), RawData);
-
-	// Create the texture and upload the uncompressed image data
-	const FString TextureBaseName = TEXT("T_") + FPaths::GetBaseFilename(ImagePath);
-	UTexture2D* Texture = CreateTexture(Outer, RawData, ImageWrapper->GetWidth(), ImageWrapper->GetHeight(), Format, ImageWrapper->GetBitDepth(),
-										TextureKey, FName(*TextureBaseName));
-	const auto TimeStamp = FPlatformFileManager::Get().GetPlatformFile().GetAccessTimeStamp(*ImagePath);
-
-	return {Texture, NumChannels, TimeStamp};
+	NewTexture->UpdateResource();
+	return NewTexture;
 }
 
-EBlendMode ChooseBlendModeFromOpacityMap(const Vitruvio::FTextureData& OpacityMapData, bool UseAlphaAsOpacity)
+Vitruvio::FOpacityMapHistogram CountTexturePixels(const UTexture2D* OpacityMap, bool UseAlphaAsOpacity)
 {
-	const UTexture2D* OpacityMap = OpacityMapData.Texture;
 	const EPixelFormat PixelFormat = OpacityMap->GetPixelFormat();
 	check(PixelFormat == PF_B8G8R8A8 || PixelFormat == PF_G8 || PixelFormat == PF_G16);
 
-	uint32 BlackPixels = 0;
-	uint32 WhitePixels = 0;
+	FByteBulkData& BulkData = OpacityMap->PlatformData->Mips[0].BulkData;
+	const void* ImageData = BulkData.LockReadOnly();
+	const int64 NumPixels = static_cast<int64>(OpacityMap->GetSizeX()) * OpacityMap->GetSizeY();
 
+	Vitruvio::FOpacityMapHistogram Histogram;
 	switch (PixelFormat)
 	{
 	case PF_B8G8R8A8:
-	{
-		const FColor* ImageData = reinterpret_cast<const FColor*>(OpacityMap->PlatformData->Mips[0].BulkData.LockReadOnly());
-
-		// Now count the black and white pixels of the appropriate opacity map channel to determine the opacity mode
-		CountOpacityMapPixels(ImageData, UseAlphaAsOpacity, OpacityMap->GetSizeX(), OpacityMap->GetSizeY(), BlackPixels, WhitePixels);
+		Histogram = Vitruvio::CountOpacityMapPixels(static_cast<const FColor*>(ImageData), NumPixels, UseAlphaAsOpacity);
 		break;
-	}
 	case PF_G8:
-	{
-		const uint8* ImageData = reinterpret_cast<const uint8*>(OpacityMap->PlatformData->Mips[0].BulkData.LockReadOnly());
-		CountOpacityMapPixels(ImageData, OpacityMap->GetSizeX(), OpacityMap->GetSizeY(), BlackPixels, WhitePixels);
+		Histogram = Vitruvio::CountOpacityMapPixels(static_cast<const uint8*>(ImageData), NumPixels);
 		break;
-	}
 	case PF_G16:
-	{
-		const uint16* ImageData = reinterpret_cast<const uint16*>(OpacityMap->PlatformData->Mips[0].BulkData.LockReadOnly());
-		CountOpacityMapPixels(ImageData, OpacityMap->GetSizeX(), OpacityMap->GetSizeY(), BlackPixels, WhitePixels);
+		Histogram = Vitruvio::CountOpacityMapPixels(static_cast<const uint16*>(ImageData), NumPixels);
 		break;
-	}
 	default:
 		check(0)
 	}
 
-	OpacityMap->PlatformData->Mips[0].BulkData.Unlock();
+	BulkData.Unlock();
+	return Histogram;
+}
 
-	const uint32 TotalPixels = OpacityMap->GetSizeX() * OpacityMap->GetSizeY();
-	if (WhitePixels >= TotalPixels * OPACITY_THRESHOLD)
+EBlendMode ChooseBlendModeFromOpacityMap(const Vitruvio::FTextureData& OpacityMapData, bool UseAlphaAsOpacity)
+{
+	// Textures are classified when they are loaded, only (uncompressed) 16 bit textures are counted here
+	Vitruvio::EOpacityMapClass OpacityClass = OpacityMapData.OpacityClass;
+	if (OpacityClass == Vitruvio::EOpacityMapClass::Unknown)
 	{
-		return BLEND_Opaque;
+		OpacityClass = Vitruvio::ClassifyOpacityMap(CountTexturePixels(OpacityMapData.Texture, UseAlphaAsOpacity));
 	}
-	if (WhitePixels + BlackPixels >= TotalPixels * OPACITY_THRESHOLD)
+
+	switch (OpacityClass)
 	{
+	case Vitruvio::EOpacityMapClass::Opaque:
+		return BLEND_Opaque;
+	case Vitruvio::EOpacityMapClass::Masked:
 		return BLEND_Masked;
+	default:
+		return BLEND_Translucent;
 	}
-	return BLEND_Translucent;
 }
 
 EBlendMode ChooseBlendMode(const Vitruvio::FTextureData& OpacityMapData, double Opacity, EBlendMode BlendMode, bool UseAlphaAsOpacity)
@@ -308,133 +260,85 @@ UMaterialInterface* GetMaterialByBlendMode(EBlendMode Mode, UMaterialInterface*
 	}
 }
 
-class FLoadTextureTask
+} // namespace
+
+namespace Vitruvio
 {
-	TPromise<Vitruvio::FTextureData> Promise;
-	UObject* Outer;
-	TMap<FString, Vitruvio::FTextureData>& Cache;
-	FCriticalSection& CacheCriticalSection;
-
-	FString ImagePath;
-	FString TextureKey;
-
-public:
-	FLoadTextureTask(TPromise<Vitruvio::FTextureData>&& InPromise, UObject* Outer, TMap<FString, Vitruvio::FTextureData>& Cache,
-					 FCriticalSection& CacheCriticalSection, const FString& ImagePath, const FString& TextureKey)
-		: Promise(MoveTemp(InPromise)), Outer(Outer), Cache(Cache), CacheCriticalSection(CacheCriticalSection), ImagePath(ImagePath),
-		  TextureKey(TextureKey)
+FTextureData LoadTextureFromDisk(const FString& ImagePath, const FString& TextureKey)
+{
+	static IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+
+	if (!FPaths::FileExists(ImagePath))
 	{
+		UE_LOG(LogMaterialConversion, Error, TEXT("File not found: %s"), *ImagePath);
+		return {};
 	}
 
-	static const TCHAR* GetTaskName()
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *ImagePath))
 	{
-		return TEXT("FLoadTextureTask");
+		UE_LOG(LogMaterialConversion, Error, TEXT("Failed to load file: %s"), *ImagePath);
+		return {};
 	}
-	FORCEINLINE static TStatId GetStatId()
+	const EImageFormat ImageFormat = ImageWrapperModule.DetectImageFormat(FileData.GetData(), FileData.Num());
+	if (ImageFormat == EImageFormat::Invalid)
 	{
-		RETURN_QUICK_DECLARE_CYCLE_STAT(FLoadResolveMapTask, STATGROUP_TaskGraphTasks);
+		UE_LOG(LogMaterialConversion, Error, TEXT("Unrecognized image file format: %s"), *ImagePath);
+		return {};
 	}
 
-	static ENamedThreads::Type GetDesiredThread()
-	{
-		return ENamedThreads::AnyBackgroundThreadNormalTask;
-	}
+	TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(ImageFormat);
 
-	static ESubsequentsMode::Type GetSubsequentsMode()
+	if (!ImageWrapper.IsValid())
 	{
-		return ESubsequentsMode::TrackSubsequents;
+		UE_LOG(LogMaterialConversion, Error, TEXT("Failed to create image wrapper for file: %s"), *ImagePath);
+		return {};
 	}
 
-	void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
-	{
-		QUICK_SCOPE_CYCLE_COUNTER(STAT_MaterialConversion_LoadTexture);
-		Vitruvio::FTextureData TextureData = LoadTextureFromDisk(Outer, ImagePath, TextureKey);
+	// Unfortunately using the IImageWrapperModule to load textures will always result in images with alpha channels even if
+	// the original texture does not contain an alpha channel. Since we have to check the existence of alpha channels to determine
+	// the blend mode we need to extract real number of channels manually.
+	const uint32 NumChannels = Vitruvio::DetectChannels(ImageFormat, FileData.GetData(), FileData.Num());
 
-		{
-			FScopeLock CacheLock(&CacheCriticalSection);
+	// Decompress the image data
+	TArray64<uint8> RawData;
+	ImageWrapper->SetCompressed(FileData.GetData(), FileData.Num());
+	const ERGBFormat Format = GetRequestedFormat(ImageWrapper->GetFormat());
+	ImageWrapper->GetRaw(Format, ImageWrapper->GetBitDepth(), RawData);
 
-			Cache.Add(ImagePath, TextureData);
-		}
+	// Create the texture, which generates the mips and compresses the image data if possible
+	const FString TextureBaseName = TEXT("T_") + FPaths::GetBaseFilename(ImagePath);
+	UTexture2D* Texture = CreateTexture(GetTransientPackage(), RawData, ImageWrapper->GetWidth(), ImageWrapper->GetHeight(), Format,
+										ImageWrapper->GetBitDepth(), NumChannels == 4, TextureKey, FName(*TextureBaseName));
+	FTextureData TextureData{Texture, NumChannels};
 
-		Promise.SetValue(TextureData);
+	// Classify the texture right away (on the loading thread) so that choosing the blend mode of materials using it as opacity map is cheap.
+	// This is done for all 8 bit textures since they are block compressed and can not be read back later.
+	const int64 NumPixels = static_cast<int64>(ImageWrapper->GetWidth()) * ImageWrapper->GetHeight();
+	if (Format == ERGBFormat::BGRA && ImageWrapper->GetBitDepth() == 8 && RawData.Num() == NumPixels * static_cast<int64>(sizeof(FColor)))
+	{
+		const bool UseAlphaAsOpacity = NumChannels == 4;
+		TextureData.OpacityClass =
+			ClassifyOpacityMap(CountOpacityMapPixels(reinterpret_cast<const FColor*>(RawData.GetData()), NumPixels, UseAlphaAsOpacity));
 	}
-};
 
-} // namespace
+	return TextureData;
+}
 
-namespace Vitruvio
-{
 UMaterialInstanceDynamic* GameThread_CreateMaterialInstance(UObject* Outer, const FName& Name, UMaterialInterface* OpaqueParent,
 															UMaterialInterface* MaskedParent, UMaterialInterface* TranslucentParent,
-															const FMaterialAttributeContainer& MaterialContainer,
-															TMap<FString, FTextureData>& TextureCache)
+															const FMaterialAttributeContainer& MaterialContainer, FTextureCache& TextureCache)
 {
 	check(IsInGameThread());
 
-	TMap<FString, FGraphEventRef> TexturePropertyTasks;
-	TMap<FString, TFuture<FTextureData>> TextureProperties;
-
-	FCriticalSection CacheCriticalSection;
-
+	// The textures are usually already loaded (see UVitruvioComponent::ApplyNextStep), otherwise the loads are shared with other materials
+	// and waited for below
+	TMap<FString, TSharedFuture<FTextureData>> TextureProperties;
 	for (const auto& TextureProperty : MaterialContainer.TextureProperties)
 	{
-		const FString TexturePath = TextureProperty.Value;
-		TPromise<FTextureData> Promise;
-		TFuture<FTextureData> Future = Promise.GetFuture();
-
-		bool ValidCache = false;
-		{
-			FScopeLock CacheLock(&CacheCriticalSection);
-
-			auto Cached = TextureCache.Find(TexturePath);
-			if (Cached)
-			{
-				auto FileSystemTimeStamp = FPlatformFileManager::Get().GetPlatformFile().GetAccessTimeStamp(*TexturePath);
-				if (FileSystemTimeStamp > Cached->LoadTime)
-				{
-					// If the timestamp on the filesystem is newer than our cached version we have to evict it from the cache and reload the texture
-					// because it has changed
-					TextureCache.Remove(*TextureCache.FindKey(*Cached));
-				}
-				else
-				{
-					// Found a valid entry in the cache which we can just use
-					Promise.SetValue(*Cached);
-					ValidCache = true;
-				}
-			}
-		}
-
-		if (!ValidCache)
-		{
-			// No valid entry found in the cache so we have to load it from the disk
-			auto LoadTextureTask = TexturePropertyTasks.Find(TexturePath);
-			if (LoadTextureTask)
-			{
-				FGraphEventArray Prerequisites;
-				Prerequisites.Add(*LoadTextureTask);
-				TGraphTask<TAsyncGraphTask<FTextureData>>::CreateTask(&Prerequisites)
-					.ConstructAndDispatchWhenReady(
-						[&TextureCache, TexturePath, &CacheCriticalSection]() {
-							FScopeLock CacheLock(&CacheCriticalSection);
-							return TextureCache[TexturePath];
-						},
-						MoveTemp(Promise), ENamedThreads::AnyThread);
-			}
-			else if (!TexturePath.IsEmpty())
-			{
-				FGraphEventRef LoadTask = TGraphTask<FLoadTextureTask>::CreateTask().ConstructAndDispatchWhenReady(
-					MoveTemp(Promise), Outer, TextureCache, CacheCriticalSection, TextureProperty.Value, TextureProperty.Key);
-				TexturePropertyTasks.Add(TexturePath, LoadTask);
-			}
-			else
-			{
-				Promise.SetValue({});
-			}
-		}
-
-		TextureProperties.Add(TextureProperty.Key, MoveTemp(Future));
+		TextureProperties.Add(TextureProperty.Key, TextureCache.LoadAsync(TextureProperty.Value, TextureProperty.Key));
 	}
+
 	const float Opacity = MaterialContainer.ScalarProperties["opacity"];
 	const FTextureData OpacityMapData = TextureProperties.Contains("opacityMap") ? TextureProperties["opacityMap"].Get() : FTextureData{};
 	const bool UseAlphaAsOpacity = OpacityMapData.Texture && OpacityMapData.NumChannels == 4;
@@ -460,9 +364,9 @@ UMaterialInstanceDynamic* GameThread_CreateMaterialInstance(UObject* Outer, cons
 
 	MaterialInstance->SetScalarParameterValue(FName(TEXT("opacitySource")), UseAlphaAsOpacity);
 
-	for (const TPair<FString, TFuture<FTextureData>>& TextureFuture : TextureProperties)
+	for (const TPair<FString, TSharedFuture<FTextureData>>& TextureFuture : TextureProperties)
 	{
-		const auto Result = TextureFuture.Value.Get();
+		const FTextureData& Result = TextureFuture.Value.Get();
 		MaterialInstance->SetTextureParameterValue(FName(TextureFuture.Key), Result.Texture);
 	}
 	for (const TPair<FString, double>& ScalarProperty : MaterialContainer.ScalarProperties)
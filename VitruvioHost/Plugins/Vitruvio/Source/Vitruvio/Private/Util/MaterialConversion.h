@@ -25,8 +25,16 @@ DECLARE_LOG_CATEGORY_EXTERN(LogMaterialConversion, Log, All);
 
 namespace Vitruvio
 {
+class FTextureCache;
+
+/** Loads the image at the given path into a new transient texture. Can be called from any thread. */
+FTextureData LoadTextureFromDisk(const FString& ImagePath, const FString& TextureKey);
+
+/**
+ * Creates a material instance for the given attributes, the textures are acquired from the texture cache. Blocks until the textures are
+ * loaded, callers should therefore wait for the loads beforehand.
+ */
 UMaterialInstanceDynamic* GameThread_CreateMaterialInstance(UObject* Outer, const FName& Name, UMaterialInterface* OpaqueParent,
 															UMaterialInterface* MaskedParent, UMaterialInterface* TranslucentParent,
-															const FMaterialAttributeContainer& MaterialAttributes,
-															TMap<FString, FTextureData>& TextureCache);
+															const FMaterialAttributeContainer& MaterialAttributes, FTextureCache& TextureCache);
 }
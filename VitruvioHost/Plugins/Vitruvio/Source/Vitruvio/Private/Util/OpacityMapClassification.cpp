@@ -0,0 +1,326 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OpacityMapClassification.h"
+
+#if PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#define VITRUVIO_OPACITY_NEON 1
+#elif PLATFORM_CPU_X86_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS
+#include <emmintrin.h>
+#define VITRUVIO_OPACITY_SSE2 1
+#endif
+
+namespace
+{
+constexpr double BLACK_COLOR_THRESHOLD = 0.02;
+constexpr double WHITE_COLOR_THRESHOLD = 1.0 - BLACK_COLOR_THRESHOLD;
+constexpr double OPACITY_THRESHOLD = 0.98;
+
+// Integer versions of the color thresholds: a value is black if it is smaller than BlackLimit and white if it is larger than WhiteLimit
+constexpr int32 BlackLimit(int32 MaxValue)
+{
+	const double Limit = BLACK_COLOR_THRESHOLD * MaxValue;
+	return Limit > static_cast<int32>(Limit) ? static_cast<int32>(Limit) + 1 : static_cast<int32>(Limit);
+}
+
+constexpr int32 WhiteLimit(int32 MaxValue)
+{
+	return static_cast<int32>(WHITE_COLOR_THRESHOLD * MaxValue);
+}
+
+constexpr int32 BLACK_LIMIT_8 = BlackLimit(0xFF);
+constexpr int32 WHITE_LIMIT_8 = WhiteLimit(0xFF);
+constexpr int32 BLACK_LIMIT_16 = BlackLimit(0xFFFF);
+constexpr int32 WHITE_LIMIT_16 = WhiteLimit(0xFFFF);
+
+// Number of pixels processed per 8 bit and 16 bit vector
+constexpr int64 BLOCK_SIZE_8 = 16;
+constexpr int64 BLOCK_SIZE_16 = 8;
+
+template <typename T, typename F>
+Vitruvio::FOpacityMapHistogram CountPixelsScalar(const T* Pixels, int64 NumPixels, int32 BlackLimitValue, int32 WhiteLimitValue, F Accessor)
+{
+	Vitruvio::FOpacityMapHistogram Histogram;
+	Histogram.TotalPixels = NumPixels;
+	for (int64 Index = 0; Index < NumPixels; ++Index)
+	{
+		const int32 Value = Accessor(Pixels[Index]);
+		Histogram.BlackPixels += Value < BlackLimitValue;
+		Histogram.WhitePixels += Value > WhiteLimitValue;
+	}
+	return Histogram;
+}
+
+void Accumulate(Vitruvio::FOpacityMapHistogram& Histogram, const Vitruvio::FOpacityMapHistogram& Other)
+{
+	Histogram.BlackPixels += Other.BlackPixels;
+	Histogram.WhitePixels += Other.WhitePixels;
+	Histogram.TotalPixels += Other.TotalPixels;
+}
+
+#if VITRUVIO_OPACITY_SSE2
+
+using FByteVector = __m128i;
+
+int64 SumLanes(__m128i Sums)
+{
+	alignas(16) int64 Lanes[2];
+	_mm_store_si128(reinterpret_cast<__m128i*>(Lanes), Sums);
+	return Lanes[0] + Lanes[1];
+}
+
+FByteVector LoadBytes(const uint8* Pixels)
+{
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(Pixels));
+}
+
+FByteVector LoadChannel(const FColor* Pixels, bool bUseAlphaChannel)
+{
+	// Shift the channel into the lowest byte of every pixel and pack the 16 pixels into one vector of bytes
+	const __m128i Shift = _mm_cvtsi32_si128(bUseAlphaChannel ? 24 : 16);
+	const __m128i Mask = _mm_set1_epi32(0xFF);
+	const __m128i* Data = reinterpret_cast<const __m128i*>(Pixels);
+	const __m128i P0 = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128(Data + 0), Shift), Mask);
+	const __m128i P1 = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128(Data + 1), Shift), Mask);
+	const __m128i P2 = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128(Data + 2), Shift), Mask);
+	const __m128i P3 = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128(Data + 3), Shift), Mask);
+	return _mm_packus_epi16(_mm_packs_epi32(P0, P1), _mm_packs_epi32(P2, P3));
+}
+
+template <typename FLoad>
+void CountBlocks8(int64 NumBlocks, FLoad Load, Vitruvio::FOpacityMapHistogram& Histogram)
+{
+	// SSE2 has no unsigned byte comparisons, v <= Max is computed as min(v, Max) == v
+	const __m128i BlackMax = _mm_set1_epi8(static_cast<char>(BLACK_LIMIT_8 - 1));
+	const __m128i WhiteMin = _mm_set1_epi8(static_cast<char>(WHITE_LIMIT_8 + 1));
+	const __m128i Zero = _mm_setzero_si128();
+
+	__m128i BlackSums = Zero;
+	__m128i WhiteSums = Zero;
+	int64 Block = 0;
+	while (Block < NumBlocks)
+	{
+		// The byte counters overflow after 255 blocks, they are summed up into 64 bit counters before
+		const int64 BatchEnd = FMath::Min(Block + 255, NumBlocks);
+		__m128i BlackCounts = Zero;
+		__m128i WhiteCounts = Zero;
+		for (; Block < BatchEnd; ++Block)
+		{
+			const __m128i Values = Load(Block);
+			BlackCounts = _mm_sub_epi8(BlackCounts, _mm_cmpeq_epi8(_mm_min_epu8(Values, BlackMax), Values));
+			WhiteCounts = _mm_sub_epi8(WhiteCounts, _mm_cmpeq_epi8(_mm_max_epu8(Values, WhiteMin), Values));
+		}
+		BlackSums = _mm_add_epi64(BlackSums, _mm_sad_epu8(BlackCounts, Zero));
+		WhiteSums = _mm_add_epi64(WhiteSums, _mm_sad_epu8(WhiteCounts, Zero));
+	}
+
+	Histogram.BlackPixels += SumLanes(BlackSums);
+	Histogram.WhitePixels += SumLanes(WhiteSums);
+	Histogram.TotalPixels += NumBlocks * BLOCK_SIZE_8;
+}
+
+void CountBlocks16(const uint16* Pixels, int64 NumBlocks, Vitruvio::FOpacityMapHistogram& Histogram)
+{
+	// SSE2 has only signed 16 bit comparisons, the values are therefore biased into the signed range
+	const __m128i Bias = _mm_set1_epi16(static_cast<int16>(0x8000));
+	const __m128i BlackLimit = _mm_set1_epi16(static_cast<int16>(BLACK_LIMIT_16 ^ 0x8000));
+	const __m128i WhiteLimit = _mm_set1_epi16(static_cast<int16>(WHITE_LIMIT_16 ^ 0x8000));
+	const __m128i Ones = _mm_set1_epi16(1);
+	const __m128i Zero = _mm_setzero_si128();
+
+	const __m128i* Data = reinterpret_cast<const __m128i*>(Pixels);
+	int64 Block = 0;
+	while (Block < NumBlocks)
+	{
+		// The (signed) 16 bit counters overflow after 32767 blocks
+		const int64 BatchEnd = FMath::Min(Block + 32767, NumBlocks);
+		__m128i BlackCounts = Zero;
+		__m128i WhiteCounts = Zero;
+		for (; Block < BatchEnd; ++Block)
+		{
+			const __m128i Values = _mm_xor_si128(_mm_loadu_si128(Data + Block), Bias);
+			BlackCounts = _mm_sub_epi16(BlackCounts, _mm_cmplt_epi16(Values, BlackLimit));
+			WhiteCounts = _mm_sub_epi16(WhiteCounts, _mm_cmpgt_epi16(Values, WhiteLimit));
+		}
+
+		alignas(16) int32 Lanes[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(Lanes), _mm_madd_epi16(BlackCounts, Ones));
+		Histogram.BlackPixels += static_cast<int64>(Lanes[0]) + Lanes[1] + Lanes[2] + Lanes[3];
+		_mm_store_si128(reinterpret_cast<__m128i*>(Lanes), _mm_madd_epi16(WhiteCounts, Ones));
+		Histogram.WhitePixels += static_cast<int64>(Lanes[0]) + Lanes[1] + Lanes[2] + Lanes[3];
+	}
+	Histogram.TotalPixels += NumBlocks * BLOCK_SIZE_16;
+}
+
+#elif VITRUVIO_OPACITY_NEON
+
+using FByteVector = uint8x16_t;
+
+int64 SumLanes(uint64x2_t Sums)
+{
+	return static_cast<int64>(vgetq_lane_u64(Sums, 0) + vgetq_lane_u64(Sums, 1));
+}
+
+FByteVector LoadBytes(const uint8* Pixels)
+{
+	return vld1q_u8(Pixels);
+}
+
+FByteVector LoadChannel(const FColor* Pixels, bool bUseAlphaChannel)
+{
+	// Deinterleaves the BGRA channels of 16 pixels
+	const uint8x16x4_t Channels = vld4q_u8(reinterpret_cast<const uint8*>(Pixels));
+	return bUseAlphaChannel ? Channels.val[3] : Channels.val[2];
+}
+
+template <typename FLoad>
+void CountBlocks8(int64 NumBlocks, FLoad Load, Vitruvio::FOpacityMapHistogram& Histogram)
+{
+	const uint8x16_t BlackLimit = vdupq_n_u8(static_cast<uint8>(BLACK_LIMIT_8));
+	const uint8x16_t WhiteLimit = vdupq_n_u8(static_cast<uint8>(WHITE_LIMIT_8));
+
+	uint64x2_t BlackSums = vdupq_n_u64(0);
+	uint64x2_t WhiteSums = vdupq_n_u64(0);
+	int64 Block = 0;
+	while (Block < NumBlocks)
+	{
+		// The byte counters overflow after 255 blocks, they are summed up into 64 bit counters before
+		const int64 BatchEnd = FMath::Min(Block + 255, NumBlocks);
+		uint8x16_t BlackCounts = vdupq_n_u8(0);
+		uint8x16_t WhiteCounts = vdupq_n_u8(0);
+		for (; Block < BatchEnd; ++Block)
+		{
+			const uint8x16_t Values = Load(Block);
+			BlackCounts = vsubq_u8(BlackCounts, vcltq_u8(Values, BlackLimit));
+			WhiteCounts = vsubq_u8(WhiteCounts, vcgtq_u8(Values, WhiteLimit));
+		}
+		BlackSums = vaddq_u64(BlackSums, vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(BlackCounts))));
+		WhiteSums = vaddq_u64(WhiteSums, vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(WhiteCounts))));
+	}
+
+	Histogram.BlackPixels += SumLanes(BlackSums);
+	Histogram.WhitePixels += SumLanes(WhiteSums);
+	Histogram.TotalPixels += NumBlocks * BLOCK_SIZE_8;
+}
+
+void CountBlocks16(const uint16* Pixels, int64 NumBlocks, Vitruvio::FOpacityMapHistogram& Histogram)
+{
+	const uint16x8_t BlackLimit = vdupq_n_u16(static_cast<uint16>(BLACK_LIMIT_16));
+	const uint16x8_t WhiteLimit = vdupq_n_u16(static_cast<uint16>(WHITE_LIMIT_16));
+
+	uint64x2_t BlackSums = vdupq_n_u64(0);
+	uint64x2_t WhiteSums = vdupq_n_u64(0);
+	int64 Block = 0;
+	while (Block < NumBlocks)
+	{
+		// The 16 bit counters overflow after 65535 blocks
+		const int64 BatchEnd = FMath::Min(Block + 65535, NumBlocks);
+		uint16x8_t BlackCounts = vdupq_n_u16(0);
+		uint16x8_t WhiteCounts = vdupq_n_u16(0);
+		for (; Block < BatchEnd; ++Block)
+		{
+			const uint16x8_t Values = vld1q_u16(Pixels + Block * BLOCK_SIZE_16);
+			BlackCounts = vsubq_u16(BlackCounts, vcltq_u16(Values, BlackLimit));
+			WhiteCounts = vsubq_u16(WhiteCounts, vcgtq_u16(Values, WhiteLimit));
+		}
+		BlackSums = vaddq_u64(BlackSums, vpaddlq_u32(vpaddlq_u16(BlackCounts)));
+		WhiteSums = vaddq_u64(WhiteSums, vpaddlq_u32(vpaddlq_u16(WhiteCounts)));
+	}
+
+	Histogram.BlackPixels += SumLanes(BlackSums);
+	Histogram.WhitePixels += SumLanes(WhiteSums);
+	Histogram.TotalPixels += NumBlocks * BLOCK_SIZE_16;
+}
+
+#endif
+
+} // namespace
+
+namespace Vitruvio
+{
+FOpacityMapHistogram CountOpacityMapPixelsScalar(const FColor* Pixels, int64 NumPixels, bool bUseAlphaChannel)
+{
+	return CountPixelsScalar(Pixels, NumPixels, BLACK_LIMIT_8, WHITE_LIMIT_8,
+							 [bUseAlphaChannel](const FColor& Color) { return bUseAlphaChannel ? Color.A : Color.R; });
+}
+
+FOpacityMapHistogram CountOpacityMapPixelsScalar(const uint8* Pixels, int64 NumPixels)
+{
+	return CountPixelsScalar(Pixels, NumPixels, BLACK_LIMIT_8, WHITE_LIMIT_8, [](uint8 Value) { return Value; });
+}
+
+FOpacityMapHistogram CountOpacityMapPixelsScalar(const uint16* Pixels, int64 NumPixels)
+{
+	return CountPixelsScalar(Pixels, NumPixels, BLACK_LIMIT_16, WHITE_LIMIT_16, [](uint16 Value) { return Value; });
+}
+
+FOpacityMapHistogram CountOpacityMapPixels(const FColor* Pixels, int64 NumPixels, bool bUseAlphaChannel)
+{
+#if VITRUVIO_OPACITY_SSE2 || VITRUVIO_OPACITY_NEON
+	FOpacityMapHistogram Histogram;
+	const int64 NumBlocks = NumPixels / BLOCK_SIZE_8;
+	CountBlocks8(
+		NumBlocks, [Pixels, bUseAlphaChannel](int64 Block) { return LoadChannel(Pixels + Block * BLOCK_SIZE_8, bUseAlphaChannel); },
+		Histogram);
+	const int64 NumVectorized = NumBlocks * BLOCK_SIZE_8;
+	Accumulate(Histogram, CountOpacityMapPixelsScalar(Pixels + NumVectorized, NumPixels - NumVectorized, bUseAlphaChannel));
+	return Histogram;
+#else
+	return CountOpacityMapPixelsScalar(Pixels, NumPixels, bUseAlphaChannel);
+#endif
+}
+
+FOpacityMapHistogram CountOpacityMapPixels(const uint8* Pixels, int64 NumPixels)
+{
+#if VITRUVIO_OPACITY_SSE2 || VITRUVIO_OPACITY_NEON
+	FOpacityMapHistogram Histogram;
+	const int64 NumBlocks = NumPixels / BLOCK_SIZE_8;
+	CountBlocks8(NumBlocks, [Pixels](int64 Block) { return LoadBytes(Pixels + Block * BLOCK_SIZE_8); }, Histogram);
+	const int64 NumVectorized = NumBlocks * BLOCK_SIZE_8;
+	Accumulate(Histogram, CountOpacityMapPixelsScalar(Pixels + NumVectorized, NumPixels - NumVectorized));
+	return Histogram;
+#else
+	return CountOpacityMapPixelsScalar(Pixels, NumPixels);
+#endif
+}
+
+FOpacityMapHistogram CountOpacityMapPixels(const uint16* Pixels, int64 NumPixels)
+{
+#if VITRUVIO_OPACITY_SSE2 || VITRUVIO_OPACITY_NEON
+	FOpacityMapHistogram Histogram;
+	const int64 NumBlocks = NumPixels / BLOCK_SIZE_16;
+	CountBlocks16(Pixels, NumBlocks, Histogram);
+	const int64 NumVectorized = NumBlocks * BLOCK_SIZE_16;
+	Accumulate(Histogram, CountOpacityMapPixelsScalar(Pixels + NumVectorized, NumPixels - NumVectorized));
+	return Histogram;
+#else
+	return CountOpacityMapPixelsScalar(Pixels, NumPixels);
+#endif
+}
+
+EOpacityMapClass ClassifyOpacityMap(const FOpacityMapHistogram& Histogram)
+{
+	if (Histogram.WhitePixels >= Histogram.TotalPixels * OPACITY_THRESHOLD)
+	{
+		return EOpacityMapClass::Opaque;
+	}
+	if (Histogram.WhitePixels + Histogram.BlackPixels >= Histogram.TotalPixels * OPACITY_THRESHOLD)
+	{
+		return EOpacityMapClass::Masked;
+	}
+	return EOpacityMapClass::Blend;
+}
+} // namespace Vitruvio
@@ -0,0 +1,45 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VitruvioTypes.h"
+
+#include "CoreMinimal.h"
+
+namespace Vitruvio
+{
+struct FOpacityMapHistogram
+{
+	int64 BlackPixels = 0;
+	int64 WhitePixels = 0;
+	int64 TotalPixels = 0;
+};
+
+/**
+ * Counts the black and white pixels of the alpha (or red) channel of BGRA8 image data. Uses SSE2 or NEON if available and can be called
+ * from any thread.
+ */
+FOpacityMapHistogram CountOpacityMapPixels(const FColor* Pixels, int64 NumPixels, bool bUseAlphaChannel);
+FOpacityMapHistogram CountOpacityMapPixels(const uint8* Pixels, int64 NumPixels);
+FOpacityMapHistogram CountOpacityMapPixels(const uint16* Pixels, int64 NumPixels);
+
+/** Scalar versions of CountOpacityMapPixels, used for the remaining pixels of the vectorized versions and on other platforms. */
+FOpacityMapHistogram CountOpacityMapPixelsScalar(const FColor* Pixels, int64 NumPixels, bool bUseAlphaChannel);
+FOpacityMapHistogram CountOpacityMapPixelsScalar(const uint8* Pixels, int64 NumPixels);
+FOpacityMapHistogram CountOpacityMapPixelsScalar(const uint16* Pixels, int64 NumPixels);
+
+EOpacityMapClass ClassifyOpacityMap(const FOpacityMapHistogram& Histogram);
+} // namespace Vitruvio
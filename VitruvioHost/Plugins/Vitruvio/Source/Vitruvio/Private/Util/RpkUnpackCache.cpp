@@ -0,0 +1,304 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RpkUnpackCache.h"
+
+#include "PRTUtils.h"
+
+#include "Algo/Sort.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRpkUnpackCache, Log, All);
+
+namespace
+{
+constexpr uint32 MANIFEST_MAGIC = 0x4B505256; // "VRPK"
+
+// Has to be increased whenever the manifest layout below changes
+enum class EManifestVersion : int32
+{
+	Initial = 1,
+
+	VersionPlusOne,
+	Latest = VersionPlusOne - 1
+};
+
+const TCHAR* MANIFEST_FILE_NAME = TEXT("Manifest.vrpk");
+const TCHAR* ENTRY_DIRECTORY_TOKEN = TEXT("{EntryDirectory}");
+
+struct FManifest
+{
+	// Resolve map entries, values below the entry directory are stored relative to it
+	TArray<FString> Keys;
+	TArray<FString> Values;
+
+	// All files of the entry (relative to the entry directory) with their sizes, used to validate the entry
+	TArray<FString> Files;
+	TArray<int64> FileSizes;
+	int64 SizeBytes = 0;
+
+	friend FArchive& operator<<(FArchive& Ar, FManifest& Manifest)
+	{
+		Ar << Manifest.Keys;
+		Ar << Manifest.Values;
+		Ar << Manifest.Files;
+		Ar << Manifest.FileSizes;
+		Ar << Manifest.SizeBytes;
+		return Ar;
+	}
+};
+
+bool LoadManifest(const FString& Path, FManifest& OutManifest)
+{
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *Path, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic;
+	Reader << Version;
+	if (Reader.IsError() || Magic != MANIFEST_MAGIC || Version != static_cast<int32>(EManifestVersion::Latest))
+	{
+		return false;
+	}
+
+	Reader << OutManifest;
+	return !Reader.IsError() && OutManifest.Keys.Num() == OutManifest.Values.Num() && OutManifest.Files.Num() == OutManifest.FileSizes.Num();
+}
+
+bool SaveManifest(const FString& Path, FManifest& Manifest)
+{
+	TArray<uint8> FileData;
+	FMemoryWriter Writer(FileData);
+	uint32 Magic = MANIFEST_MAGIC;
+	int32 Version = static_cast<int32>(EManifestVersion::Latest);
+	Writer << Magic;
+	Writer << Version;
+	Writer << Manifest;
+
+	// The manifest marks the entry as complete, write it to a temporary file first so that it is never seen partially written
+	const FString TempPath = FPaths::CreateTempFilename(*FPaths::GetPath(Path), TEXT("Temp_"), TEXT(".vrpk"));
+	if (!FFileHelper::SaveArrayToFile(FileData, *TempPath) || !IFileManager::Get().Move(*Path, *TempPath, true, true, false, true))
+	{
+		IFileManager::Get().Delete(*TempPath, false, true, true);
+		return false;
+	}
+	return true;
+}
+
+FString GetDirectoryUri(const FString& Directory)
+{
+	return WCHAR_TO_TCHAR(prtu::toFileURI(std::wstring(TCHAR_TO_WCHAR(*Directory))).c_str());
+}
+
+bool IsEntryComplete(const FManifest& Manifest, const FString& EntryDirectory)
+{
+	IFileManager& FileManager = IFileManager::Get();
+	for (int32 FileIndex = 0; FileIndex < Manifest.Files.Num(); ++FileIndex)
+	{
+		if (FileManager.FileSize(*FPaths::Combine(EntryDirectory, Manifest.Files[FileIndex])) != Manifest.FileSizes[FileIndex])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+ResolveMapSPtr CreateResolveMap(const FManifest& Manifest, const FString& EntryDirectory)
+{
+	const FString EntryDirectoryUri = GetDirectoryUri(EntryDirectory);
+
+	const ResolveMapBuilderUPtr Builder(prt::ResolveMapBuilder::create());
+	for (int32 Index = 0; Index < Manifest.Keys.Num(); ++Index)
+	{
+		const FString Value = Manifest.Values[Index].Replace(ENTRY_DIRECTORY_TOKEN, *EntryDirectoryUri, ESearchCase::CaseSensitive);
+		Builder->addEntry(TCHAR_TO_WCHAR(*Manifest.Keys[Index]), TCHAR_TO_WCHAR(*Value));
+	}
+
+	prt::Status Status;
+	ResolveMapSPtr ResolveMap(Builder->createResolveMap(&Status), PRTDestroyer());
+	return Status == prt::STATUS_OK ? ResolveMap : nullptr;
+}
+} // namespace
+
+namespace Vitruvio
+{
+FRpkUnpackCache::FRpkUnpackCache(const FString& InDirectory, int64 BudgetBytes)
+	: Directory(FPaths::ConvertRelativePathToFull(InDirectory)), BudgetBytes(BudgetBytes)
+{
+	FPaths::NormalizeDirectoryName(Directory);
+	IFileManager::Get().MakeDirectory(*Directory, true);
+}
+
+ResolveMapSPtr FRpkUnpackCache::GetResolveMap(const FString& Name, const FSHAHash& ContentHash,
+											  TFunctionRef<bool(const FString& RpkPath)> WriteRulePackage)
+{
+	const FString Key = ContentHash.ToString();
+	const FString EntryDirectory = FPaths::Combine(Directory, Key);
+	const FString ManifestPath = FPaths::Combine(EntryDirectory, MANIFEST_FILE_NAME);
+
+	// Used entries are never evicted, marking the entry as used therefore also protects it while it is unpacked
+	TSharedPtr<FCriticalSection, ESPMode::ThreadSafe> EntryLock;
+	{
+		FScopeLock ScopeLock(&Lock);
+		UsedEntries.Add(Key);
+
+		const TSharedRef<FCriticalSection, ESPMode::ThreadSafe>* ExistingEntryLock = EntryLocks.Find(Key);
+		EntryLock = ExistingEntryLock ? *ExistingEntryLock : EntryLocks.Add(Key, MakeShared<FCriticalSection, ESPMode::ThreadSafe>());
+	}
+
+	ResolveMapSPtr ResolveMap;
+	{
+		// Different rule packages might have the same content, an entry is therefore only accessed while holding its lock
+		FScopeLock EntryScopeLock(EntryLock.Get());
+
+		FManifest Manifest;
+		if (LoadManifest(ManifestPath, Manifest) && IsEntryComplete(Manifest, EntryDirectory))
+		{
+			ResolveMap = CreateResolveMap(Manifest, EntryDirectory);
+			if (ResolveMap)
+			{
+				// The time stamp of the manifest is used to find the least recently used entries
+				IFileManager::Get().SetTimeStamp(*ManifestPath, FDateTime::UtcNow());
+				return ResolveMap;
+			}
+		}
+
+		ResolveMap = Unpack(Name, WriteRulePackage, EntryDirectory);
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	EvictUnused();
+	return ResolveMap;
+}
+
+ResolveMapSPtr FRpkUnpackCache::Unpack(const FString& Name, TFunctionRef<bool(const FString& RpkPath)> WriteRulePackage,
+									   const FString& EntryDirectory) const
+{
+	IFileManager& FileManager = IFileManager::Get();
+
+	// Remove the remainders of an incomplete entry (eg. if the editor has been closed while unpacking)
+	FileManager.DeleteDirectory(*EntryDirectory, false, true);
+	FileManager.MakeDirectory(*EntryDirectory, true);
+
+	const FString RpkPath = FPaths::Combine(EntryDirectory, Name + TEXT(".rpk"));
+	if (!WriteRulePackage(RpkPath))
+	{
+		UE_LOG(LogRpkUnpackCache, Error, TEXT("Could not write rule package %s"), *RpkPath)
+		return nullptr;
+	}
+
+	const FString UnpackDirectory = FPaths::Combine(EntryDirectory, Name + TEXT("_Unpacked"));
+	const std::wstring RpkFileUri = prtu::toFileURI(std::wstring(TCHAR_TO_WCHAR(*RpkPath)));
+
+	prt::Status Status;
+	const ResolveMapSPtr ResolveMap(prt::createResolveMap(RpkFileUri.c_str(), TCHAR_TO_WCHAR(*UnpackDirectory), &Status), PRTDestroyer());
+	if (!ResolveMap || Status != prt::STATUS_OK)
+	{
+		UE_LOG(LogRpkUnpackCache, Error, TEXT("Could not unpack rule package %s: %hs"), *RpkPath, prt::getStatusDescription(Status))
+		return ResolveMap;
+	}
+
+	FManifest Manifest;
+	const FString EntryDirectoryUri = GetDirectoryUri(EntryDirectory);
+	size_t NumKeys = 0;
+	const wchar_t* const* Keys = ResolveMap->getKeys(&NumKeys);
+	for (size_t KeyIndex = 0; KeyIndex < NumKeys; ++KeyIndex)
+	{
+		const wchar_t* Value = ResolveMap->getString(Keys[KeyIndex]);
+		if (!Value)
+		{
+			continue;
+		}
+
+		FString ValueString(WCHAR_TO_TCHAR(Value));
+		if (ValueString.StartsWith(EntryDirectoryUri, ESearchCase::CaseSensitive))
+		{
+			ValueString = ENTRY_DIRECTORY_TOKEN + ValueString.RightChop(EntryDirectoryUri.Len());
+		}
+		Manifest.Keys.Add(WCHAR_TO_TCHAR(Keys[KeyIndex]));
+		Manifest.Values.Add(MoveTemp(ValueString));
+	}
+
+	FileManager.IterateDirectoryStatRecursively(*EntryDirectory, [&](const TCHAR* FilePath, const FFileStatData& StatData) {
+		if (!StatData.bIsDirectory)
+		{
+			FString RelativePath = FilePath;
+			FPaths::MakePathRelativeTo(RelativePath, *(EntryDirectory + TEXT("/")));
+			Manifest.Files.Add(MoveTemp(RelativePath));
+			Manifest.FileSizes.Add(StatData.FileSize);
+			Manifest.SizeBytes += StatData.FileSize;
+		}
+		return true;
+	});
+
+	if (!SaveManifest(FPaths::Combine(EntryDirectory, MANIFEST_FILE_NAME), Manifest))
+	{
+		UE_LOG(LogRpkUnpackCache, Warning, TEXT("Could not write the manifest of unpacked rule package %s"), *RpkPath)
+	}
+
+	return ResolveMap;
+}
+
+void FRpkUnpackCache::EvictUnused() const
+{
+	struct FEntryInfo
+	{
+		FString Key;
+		FDateTime LastUsed;
+		int64 SizeBytes;
+	};
+
+	IFileManager& FileManager = IFileManager::Get();
+
+	TArray<FEntryInfo> Entries;
+	int64 TotalSizeBytes = 0;
+	FileManager.IterateDirectory(*Directory, [&](const TCHAR* Path, bool bIsDirectory) {
+		FManifest Manifest;
+		const FString ManifestPath = FPaths::Combine(Path, MANIFEST_FILE_NAME);
+		if (bIsDirectory && LoadManifest(ManifestPath, Manifest))
+		{
+			Entries.Add({FPaths::GetCleanFilename(Path), FileManager.GetTimeStamp(*ManifestPath), Manifest.SizeBytes});
+			TotalSizeBytes += Manifest.SizeBytes;
+		}
+		return true;
+	});
+
+	Algo::SortBy(Entries, &FEntryInfo::LastUsed);
+	for (const FEntryInfo& Entry : Entries)
+	{
+		if (TotalSizeBytes <= BudgetBytes)
+		{
+			break;
+		}
+		if (UsedEntries.Contains(Entry.Key))
+		{
+			continue;
+		}
+
+		UE_LOG(LogRpkUnpackCache, Verbose, TEXT("Evicting unpacked rule package %s"), *Entry.Key)
+		FileManager.DeleteDirectory(*FPaths::Combine(Directory, Entry.Key), false, true);
+		TotalSizeBytes -= Entry.SizeBytes;
+	}
+}
+} // namespace Vitruvio
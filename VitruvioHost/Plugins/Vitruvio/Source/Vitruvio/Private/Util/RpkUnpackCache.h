@@ -0,0 +1,70 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "PRTTypes.h"
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/SecureHash.h"
+#include "Templates/Function.h"
+
+namespace Vitruvio
+{
+/**
+ * Persistent cache of unpacked rule packages, shared across editor sessions. Every rule package is written and unpacked into a directory
+ * named after the hash of its content. A manifest, which is written once unpacking succeeded, stores the resolve map entries so that later
+ * sessions can create the resolve map without writing and unpacking the rule package again.
+ *
+ * The least recently used unpacked rule packages are deleted once the total size exceeds the budget. Rule packages used in this session
+ * are never deleted since their resolve maps reference the unpacked files.
+ */
+class FRpkUnpackCache
+{
+public:
+	FRpkUnpackCache(const FString& Directory, int64 BudgetBytes);
+
+	/**
+	 * Returns the resolve map of the rule package with the given content, unpacking it only if there is no valid unpacked version yet.
+	 * Can be called from any thread.
+	 *
+	 * \param Name the name of the rule package, used for the file names of the unpacked rule package.
+	 * \param ContentHash the hash of the content of the rule package.
+	 * \param WriteRulePackage writes the content of the rule package to the given path. Only called if the rule package has to be unpacked.
+	 * \return the resolve map or nullptr if the rule package could not be unpacked.
+	 */
+	ResolveMapSPtr GetResolveMap(const FString& Name, const FSHAHash& ContentHash, TFunctionRef<bool(const FString& RpkPath)> WriteRulePackage);
+
+	const FString& GetDirectory() const
+	{
+		return Directory;
+	}
+
+private:
+	ResolveMapSPtr Unpack(const FString& Name, TFunctionRef<bool(const FString& RpkPath)> WriteRulePackage, const FString& EntryDirectory) const;
+	void EvictUnused() const;
+
+	FString Directory;
+	int64 BudgetBytes;
+
+	// Guards the bookkeeping below and eviction. Entries are written and unpacked while only holding the lock of the entry, so that
+	// unrelated rule packages are unpacked concurrently.
+	FCriticalSection Lock;
+	// Hashes of the rule packages used in this session
+	TSet<FString> UsedEntries;
+	TMap<FString, TSharedRef<FCriticalSection, ESPMode::ThreadSafe>> EntryLocks;
+};
+} // namespace Vitruvio
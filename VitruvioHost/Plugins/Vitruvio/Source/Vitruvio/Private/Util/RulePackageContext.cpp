@@ -0,0 +1,52 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RulePackageContext.h"
+
+#include "PRTUtils.h"
+#include "VitruvioModule.h"
+
+namespace Vitruvio
+{
+TSharedPtr<const FRulePackageContext> FRulePackageContext::Create(ResolveMapSPtr ResolveMap, prt::Cache* Cache)
+{
+	if (!ResolveMap)
+	{
+		return nullptr;
+	}
+
+	const TSharedPtr<FRulePackageContext> Context = MakeShared<FRulePackageContext>();
+	Context->RuleFile = prtu::getRuleFileEntry(ResolveMap);
+	const wchar_t* RuleFileUri = ResolveMap->getString(Context->RuleFile.c_str());
+	if (Context->RuleFile.empty() || !RuleFileUri)
+	{
+		UE_LOG(LogUnrealPrt, Error, TEXT("Rule package does not contain a rule file"))
+		return nullptr;
+	}
+
+	prt::Status InfoStatus;
+	RuleFileInfoUPtr RuleInfo(prt::createRuleFileInfo(RuleFileUri, Cache, &InfoStatus));
+	if (!RuleInfo || InfoStatus != prt::STATUS_OK)
+	{
+		UE_LOG(LogUnrealPrt, Error, TEXT("could not get rule file info from rule file %s"), RuleFileUri)
+		return nullptr;
+	}
+
+	Context->StartRule = prtu::detectStartRule(RuleInfo);
+	Context->AttributeSchema = MakeShared<FAttributeSchema>(RuleFileInfoPtr(std::move(RuleInfo)));
+	Context->ResolveMap = MoveTemp(ResolveMap);
+	return Context;
+}
+} // namespace Vitruvio
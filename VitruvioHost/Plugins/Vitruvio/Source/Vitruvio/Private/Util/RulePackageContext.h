@@ -0,0 +1,45 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "AttributeSchema.h"
+#include "PRTTypes.h"
+
+#include "CoreMinimal.h"
+
+#include <string>
+
+namespace Vitruvio
+{
+/**
+ * Everything needed to generate models or evaluate attributes of a rule package which does not depend on the individual call. It is
+ * created once when the rule package has been loaded and shared by all generate and attribute calls. Immutable once created.
+ */
+struct FRulePackageContext
+{
+	ResolveMapSPtr ResolveMap;
+	std::wstring RuleFile;
+	std::wstring StartRule;
+	TSharedPtr<const FAttributeSchema> AttributeSchema;
+
+	/**
+	 * Detects the rule file and start rule of the given resolve map and creates the attribute schema.
+	 *
+	 * \return the context or nullptr if the resolve map does not contain a valid rule file.
+	 */
+	static TSharedPtr<const FRulePackageContext> Create(ResolveMapSPtr ResolveMap, prt::Cache* Cache);
+};
+} // namespace Vitruvio
@@ -0,0 +1,53 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StaticMeshBuilder.h"
+
+#include "Async/ParallelFor.h"
+#include "StaticMeshResources.h"
+
+namespace Vitruvio
+{
+void BuildStaticMeshes(const TArray<UStaticMesh*>& StaticMeshes, const TArray<const FMeshDescription*>& MeshDescriptions)
+{
+	check(IsInGameThread());
+	check(StaticMeshes.Num() == MeshDescriptions.Num());
+
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_Vitruvio_BuildStaticMeshes);
+
+	for (UStaticMesh* StaticMesh : StaticMeshes)
+	{
+		StaticMesh->NeverStream = true;
+		StaticMesh->RenderData = MakeUnique<FStaticMeshRenderData>();
+		StaticMesh->RenderData->AllocateLODResources(1);
+	}
+
+	// Building the vertex and index buffers only reads the mesh description and the material slots of the mesh and writes to its own
+	// LOD resources. It is by far the most expensive part of building a static mesh.
+	ParallelFor(StaticMeshes.Num(), [&StaticMeshes, &MeshDescriptions](int32 MeshIndex) {
+		UStaticMesh* StaticMesh = StaticMeshes[MeshIndex];
+		StaticMesh->BuildFromMeshDescription(*MeshDescriptions[MeshIndex], StaticMesh->RenderData->LODResources[0]);
+	});
+
+	for (int32 MeshIndex = 0; MeshIndex < StaticMeshes.Num(); ++MeshIndex)
+	{
+		UStaticMesh* StaticMesh = StaticMeshes[MeshIndex];
+		StaticMesh->RenderData->ScreenSize[0].Default = 1.0f;
+		StaticMesh->RenderData->Bounds = MeshDescriptions[MeshIndex]->GetBounds();
+		StaticMesh->CalculateExtendedBounds();
+		StaticMesh->InitResources();
+	}
+}
+} // namespace Vitruvio
@@ -0,0 +1,35 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StaticMesh.h"
+#include "MeshDescription.h"
+
+namespace Vitruvio
+{
+/**
+ * Builds the render data of the given static meshes from their mesh descriptions. The vertex and index buffers of all meshes are built in
+ * parallel on worker threads, only the render resources are initialized on the game thread.
+ *
+ * Note: This is a parallel version of UStaticMesh#BuildFromMeshDescriptions restricted to meshes with a single LOD. Neither a body setup
+ * nor collision is created.
+ *
+ * @param StaticMeshes			Static meshes to build (created on the game thread with their materials already set up)
+ * @param MeshDescriptions		Mesh description for each static mesh
+ */
+void BuildStaticMeshes(const TArray<UStaticMesh*>& StaticMeshes, const TArray<const FMeshDescription*>& MeshDescriptions);
+} // namespace Vitruvio
@@ -0,0 +1,144 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StaticMeshRegistry.h"
+
+#include "GeneratedMeshCollisionDataProvider.h"
+
+#include "Components/StaticMeshComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/StaticMesh.h"
+#include "PhysicsEngine/BodySetup.h"
+
+namespace
+{
+void InitializeBodySetup(UBodySetup* BodySetup, bool GenerateComplexCollision)
+{
+	BodySetup->DefaultInstance.SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	BodySetup->CollisionTraceFlag =
+		GenerateComplexCollision ? ECollisionTraceFlag::CTF_UseComplexAsSimple : ECollisionTraceFlag::CTF_UseSimpleAsComplex;
+	BodySetup->bDoubleSidedGeometry = true;
+	BodySetup->bMeshCollideAll = true;
+	BodySetup->InvalidatePhysicsData();
+}
+} // namespace
+
+namespace Vitruvio
+{
+UStaticMesh* FStaticMeshRegistry::Acquire(const FSHAHash& ContentHash, bool bComplexCollision)
+{
+	check(IsInGameThread());
+
+	FEntry* Entry = Entries.Find({ContentHash, bComplexCollision});
+	if (!Entry)
+	{
+		return nullptr;
+	}
+
+	++Entry->NumReferences;
+	return Entry->Mesh;
+}
+
+void FStaticMeshRegistry::Add(const FSHAHash& ContentHash, bool bComplexCollision, UStaticMesh* Mesh)
+{
+	check(IsInGameThread());
+	check(Mesh && !MeshKeys.Contains(Mesh));
+
+	const FKey Key{ContentHash, bComplexCollision};
+	FEntry& Entry = Entries.Add(Key);
+	Entry.Mesh = Mesh;
+	Entry.NumReferences = 1;
+	MeshKeys.Add(Mesh, Key);
+}
+
+bool FStaticMeshRegistry::Release(UStaticMesh* Mesh)
+{
+	check(IsInGameThread());
+
+	const FKey* Key = MeshKeys.Find(Mesh);
+	if (!Key)
+	{
+		return false;
+	}
+
+	FEntry& Entry = Entries.FindChecked(*Key);
+	if (--Entry.NumReferences == 0)
+	{
+		// Components still using the mesh keep it alive, it is only not shared with new results anymore
+		Entries.Remove(*Key);
+		MeshKeys.Remove(Mesh);
+		return true;
+	}
+	return false;
+}
+
+void FStaticMeshRegistry::CreateCollision(UStaticMesh* Mesh, const FCollisionDataPtr& CollisionData, UStaticMeshComponent* Component)
+{
+	check(IsInGameThread());
+
+	const FKey* Key = Mesh ? MeshKeys.Find(Mesh) : nullptr;
+	if (!Key)
+	{
+		return;
+	}
+
+	FEntry& Entry = Entries.FindChecked(*Key);
+	if (Entry.CollisionState)
+	{
+		// The physics state of the component is created from the cooked data once it is available
+		if (!Entry.CollisionState->bCooked)
+		{
+			Entry.CollisionState->WaitingComponents.Add(Component);
+		}
+		return;
+	}
+
+	Entry.CollisionState = MakeShared<FCollisionState>();
+	Entry.CollisionState->WaitingComponents.Add(Component);
+
+	// The body setup gathers the collision data from its outer. The provider is outered to the shared mesh (which references the body
+	// setup) so that it lives as long as the mesh and not only as long as the component which happened to request the collision first.
+	UGeneratedMeshCollisionDataProvider* CollisionDataProvider = NewObject<UGeneratedMeshCollisionDataProvider>(Mesh);
+	CollisionDataProvider->SetCollisionData(CollisionData);
+	UBodySetup* BodySetup = NewObject<UBodySetup>(CollisionDataProvider);
+	InitializeBodySetup(BodySetup, Key->bComplexCollision);
+	Mesh->BodySetup = BodySetup;
+
+	// Cook the collision on a worker thread
+	TSharedPtr<FCollisionState> CollisionState = Entry.CollisionState;
+	BodySetup->CreatePhysicsMeshesAsync(FOnAsyncPhysicsCookFinished::CreateLambda([CollisionState](bool bSuccess) {
+		CollisionState->bCooked = true;
+		if (bSuccess)
+		{
+			for (const TWeakObjectPtr<UStaticMeshComponent>& WaitingComponent : CollisionState->WaitingComponents)
+			{
+				if (WaitingComponent.IsValid())
+				{
+					WaitingComponent->RecreatePhysicsState();
+				}
+			}
+		}
+		CollisionState->WaitingComponents.Empty();
+	}));
+}
+
+void FStaticMeshRegistry::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (auto& KeyAndEntry : Entries)
+	{
+		Collector.AddReferencedObject(KeyAndEntry.Value.Mesh);
+	}
+}
+} // namespace Vitruvio
@@ -0,0 +1,103 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/SecureHash.h"
+#include "UObject/GCObject.h"
+#include "UObject/WeakObjectPtr.h"
+#include "VitruvioTypes.h"
+
+class UStaticMesh;
+class UStaticMeshComponent;
+
+namespace Vitruvio
+{
+/**
+ * Static meshes shared between all Vitruvio components. Meshes are identified by the content hash of the generated mesh (geometry and
+ * materials) and the collision setting, so identical prototypes (eg. windows or doors) of different models are only built once. Meshes
+ * are reference counted and released from the registry once the last result using them is gone.
+ *
+ * The registry must only be used from the game thread.
+ */
+class FStaticMeshRegistry
+{
+public:
+	FStaticMeshRegistry() = default;
+
+	FStaticMeshRegistry(const FStaticMeshRegistry&) = delete;
+	FStaticMeshRegistry& operator=(const FStaticMeshRegistry&) = delete;
+
+	/** Returns the registered mesh and acquires a reference to it, or nullptr if there is no such mesh. */
+	UStaticMesh* Acquire(const FSHAHash& ContentHash, bool bComplexCollision);
+
+	/** Registers a newly built mesh with one reference. */
+	void Add(const FSHAHash& ContentHash, bool bComplexCollision, UStaticMesh* Mesh);
+
+	/**
+	 * Releases a reference acquired by Acquire or Add. The mesh is removed from the registry once it is no longer referenced. Returns true
+	 * if the mesh has been removed.
+	 */
+	bool Release(UStaticMesh* Mesh);
+
+	/**
+	 * Creates the collision of a registered mesh from the given collision data for the given component. The collision is only cooked once
+	 * per mesh, components which use the mesh while it is still being cooked recreate their physics state once cooking has finished.
+	 */
+	void CreateCollision(UStaticMesh* Mesh, const FCollisionDataPtr& CollisionData, UStaticMeshComponent* Component);
+
+	int32 Num() const
+	{
+		return Entries.Num();
+	}
+
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
+private:
+	struct FKey
+	{
+		FSHAHash ContentHash;
+		bool bComplexCollision;
+
+		friend bool operator==(const FKey& Lhs, const FKey& Rhs)
+		{
+			return Lhs.ContentHash == Rhs.ContentHash && Lhs.bComplexCollision == Rhs.bComplexCollision;
+		}
+
+		friend uint32 GetTypeHash(const FKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.ContentHash), GetTypeHash(Key.bComplexCollision));
+		}
+	};
+
+	// Shared with the cook callback which might only be called after the mesh has been released
+	struct FCollisionState
+	{
+		bool bCooked = false;
+		TArray<TWeakObjectPtr<UStaticMeshComponent>> WaitingComponents;
+	};
+
+	struct FEntry
+	{
+		UStaticMesh* Mesh = nullptr;
+		int32 NumReferences = 0;
+		TSharedPtr<FCollisionState> CollisionState;
+	};
+
+	TMap<FKey, FEntry> Entries;
+	TMap<UStaticMesh*, FKey> MeshKeys;
+};
+} // namespace Vitruvio
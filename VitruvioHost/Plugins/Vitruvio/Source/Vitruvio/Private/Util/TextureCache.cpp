@@ -0,0 +1,184 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextureCache.h"
+
+#include "MaterialConversion.h"
+
+#include "Async/Async.h"
+#include "Engine/Texture2D.h"
+
+namespace
+{
+TSharedFuture<Vitruvio::FTextureData> MakeReadyFuture(const Vitruvio::FTextureData& Data)
+{
+	TPromise<Vitruvio::FTextureData> Promise;
+	Promise.SetValue(Data);
+	return Promise.GetFuture().Share();
+}
+
+int64 GetTextureSize(const Vitruvio::FTextureData& Data)
+{
+	const UTexture2D* Texture = Data.Texture;
+	if (!Texture || !Texture->PlatformData)
+	{
+		return 0;
+	}
+
+	int64 Size = 0;
+	for (const FTexture2DMipMap& Mip : Texture->PlatformData->Mips)
+	{
+		Size += CalculateImageBytes(Mip.SizeX, Mip.SizeY, 0, Texture->PlatformData->PixelFormat);
+	}
+	return Size;
+}
+} // namespace
+
+namespace Vitruvio
+{
+FTextureCache::FTextureCache(int64 BudgetBytes) : BudgetBytes(BudgetBytes) {}
+
+FTextureCache::~FTextureCache()
+{
+	// Loads access the cache when they finish
+	FGenericPlatformProcess::ConditionalSleep([this]() { return NumPendingLoads.GetValue() == 0; }, 0);
+}
+
+TSharedFuture<FTextureData> FTextureCache::LoadAsync(const FString& ImagePath, const FString& TextureKey)
+{
+	if (ImagePath.IsEmpty())
+	{
+		return MakeReadyFuture({});
+	}
+
+	FScopeLock ScopeLock(&Lock);
+
+	FEntry* Entry = Entries.Find(ImagePath);
+	if (Entry)
+	{
+		LruList.RemoveNode(Entry->LruNode);
+		LruList.AddHead(ImagePath);
+		Entry->LruNode = LruList.GetHead();
+		++Entry->NumReferences;
+
+		// Loaded or currently loading, in both cases the existing load is shared
+		++Hits;
+		return Entry->Future;
+	}
+
+	++Misses;
+	FEntry& NewEntry = Entries.Add(ImagePath);
+	LruList.AddHead(ImagePath);
+	NewEntry.LruNode = LruList.GetHead();
+	NewEntry.NumReferences = 1;
+	StartLoad(ImagePath, TextureKey, NewEntry);
+	return NewEntry.Future;
+}
+
+void FTextureCache::StartLoad(const FString& ImagePath, const FString& TextureKey, FEntry& Entry)
+{
+	NumPendingLoads.Increment();
+	Entry.Future = Async(EAsyncExecution::TaskGraph, [this, ImagePath, TextureKey]() {
+					   QUICK_SCOPE_CYCLE_COUNTER(STAT_TextureCache_LoadTexture);
+					   const FTextureData Data = LoadTextureFromDisk(ImagePath, TextureKey);
+					   OnLoaded(ImagePath, Data);
+					   NumPendingLoads.Decrement();
+					   return Data;
+				   }).Share();
+}
+
+void FTextureCache::OnLoaded(const FString& ImagePath, const FTextureData& Data)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	// Entries which are still loading are never evicted
+	FEntry& Entry = Entries.FindChecked(ImagePath);
+	Entry.Data = Data;
+	Entry.bLoaded = true;
+	Entry.SizeBytes = GetTextureSize(Data);
+	SizeBytes += Entry.SizeBytes;
+
+	EvictUnused();
+}
+
+void FTextureCache::Release(const FString& ImagePath)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	FEntry* Entry = Entries.Find(ImagePath);
+	if (Entry && Entry->NumReferences > 0)
+	{
+		--Entry->NumReferences;
+		EvictUnused();
+	}
+}
+
+void FTextureCache::RemoveEntry(const FString& ImagePath)
+{
+	// The path might be owned by the LRU node which is removed
+	const FString Path = ImagePath;
+	const FEntry& Entry = Entries.FindChecked(Path);
+	SizeBytes -= Entry.SizeBytes;
+	LruList.RemoveNode(Entry.LruNode);
+	Entries.Remove(Path);
+	++Evictions;
+}
+
+void FTextureCache::EvictUnused()
+{
+	// Evict from the least recently used end, textures which are still used or loading are skipped
+	TDoubleLinkedList<FString>::TDoubleLinkedListNode* Node = LruList.GetTail();
+	while (SizeBytes > BudgetBytes && Node)
+	{
+		TDoubleLinkedList<FString>::TDoubleLinkedListNode* PrevNode = Node->GetPrevNode();
+
+		const FEntry& Entry = Entries.FindChecked(Node->GetValue());
+		if (Entry.bLoaded && Entry.NumReferences == 0)
+		{
+			RemoveEntry(Node->GetValue());
+		}
+
+		Node = PrevNode;
+	}
+}
+
+FTextureCacheStats FTextureCache::GetStats() const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	FTextureCacheStats Stats;
+	Stats.NumTextures = Entries.Num();
+	for (const auto& PathAndEntry : Entries)
+	{
+		Stats.NumLoading += PathAndEntry.Value.bLoaded ? 0 : 1;
+	}
+	Stats.SizeBytes = SizeBytes;
+	Stats.BudgetBytes = BudgetBytes;
+	Stats.Hits = Hits;
+	Stats.Misses = Misses;
+	Stats.Evictions = Evictions;
+	return Stats;
+}
+
+void FTextureCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	for (auto& PathAndEntry : Entries)
+	{
+		Collector.AddReferencedObject(PathAndEntry.Value.Data.Texture);
+	}
+}
+} // namespace Vitruvio
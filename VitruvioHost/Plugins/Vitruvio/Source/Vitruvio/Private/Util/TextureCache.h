@@ -0,0 +1,92 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "VitruvioTypes.h"
+
+#include "Async/Future.h"
+#include "Containers/List.h"
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeCounter.h"
+
+namespace Vitruvio
+{
+/**
+ * Cache of the textures loaded for generated materials, identified by their image path. Textures are loaded on worker threads and
+ * concurrent requests for the same path (from any material or component) share a single load. Textures are reference counted by the
+ * materials which use them. Once the memory budget is exceeded, the least recently used textures which are not used by any cached
+ * material anymore are evicted. Cached textures are never checked against the file system, rule packages are unpacked into immutable
+ * directories named after their content (see FRpkUnpackCache).
+ *
+ * The cache can be used from any thread.
+ */
+class FTextureCache
+{
+public:
+	explicit FTextureCache(int64 BudgetBytes);
+	~FTextureCache();
+
+	FTextureCache(const FTextureCache&) = delete;
+	FTextureCache& operator=(const FTextureCache&) = delete;
+
+	/**
+	 * Returns the texture for the given image path and acquires a reference to it which has to be released with Release. The texture is
+	 * loaded asynchronously if it is not cached yet.
+	 *
+	 * \param ImagePath the path of the image to load. An empty path results in an empty texture without acquiring a reference.
+	 * \param TextureKey the material property of the texture (eg. "normalMap") which determines the texture settings.
+	 */
+	TSharedFuture<FTextureData> LoadAsync(const FString& ImagePath, const FString& TextureKey);
+
+	/** Releases a reference acquired by LoadAsync. */
+	void Release(const FString& ImagePath);
+
+	FTextureCacheStats GetStats() const;
+
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
+private:
+	struct FEntry
+	{
+		TSharedFuture<FTextureData> Future;
+		FTextureData Data;
+		bool bLoaded = false;
+		int32 NumReferences = 0;
+		int64 SizeBytes = 0;
+		TDoubleLinkedList<FString>::TDoubleLinkedListNode* LruNode = nullptr;
+	};
+
+	void StartLoad(const FString& ImagePath, const FString& TextureKey, FEntry& Entry);
+	void OnLoaded(const FString& ImagePath, const FTextureData& Data);
+	void EvictUnused();
+	void RemoveEntry(const FString& ImagePath);
+
+	mutable FCriticalSection Lock;
+
+	TMap<FString, FEntry> Entries;
+	// Most recently used path at the head
+	TDoubleLinkedList<FString> LruList;
+
+	int64 BudgetBytes;
+	int64 SizeBytes = 0;
+	uint64 Hits = 0;
+	uint64 Misses = 0;
+	uint64 Evictions = 0;
+
+	FThreadSafeCounter NumPendingLoads;
+};
+} // namespace Vitruvio
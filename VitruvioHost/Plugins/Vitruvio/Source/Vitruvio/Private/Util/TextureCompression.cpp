@@ -0,0 +1,320 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextureCompression.h"
+
+#include "Async/ParallelFor.h"
+#include "RHI.h"
+
+namespace
+{
+constexpr int32 BLOCK_SIZE = 4;
+constexpr int32 BLOCK_PIXELS = BLOCK_SIZE * BLOCK_SIZE;
+
+uint16 ToRGB565(const FVector& Color)
+{
+	const int32 R = FMath::Clamp(FMath::RoundToInt(Color.X * 31.0f / 255.0f), 0, 31);
+	const int32 G = FMath::Clamp(FMath::RoundToInt(Color.Y * 63.0f / 255.0f), 0, 63);
+	const int32 B = FMath::Clamp(FMath::RoundToInt(Color.Z * 31.0f / 255.0f), 0, 31);
+	return static_cast<uint16>((R << 11) | (G << 5) | B);
+}
+
+FVector FromRGB565(uint16 Color)
+{
+	const int32 R = (Color >> 11) & 31;
+	const int32 G = (Color >> 5) & 63;
+	const int32 B = Color & 31;
+	return FVector((R << 3) | (R >> 2), (G << 2) | (G >> 4), (B << 3) | (B >> 2));
+}
+
+void WriteUInt16(uint16 Value, uint8* Out)
+{
+	Out[0] = static_cast<uint8>(Value & 0xFF);
+	Out[1] = static_cast<uint8>(Value >> 8);
+}
+
+/** Encodes the RGB channels of a block into 8 bytes of BC1, the endpoints are the extremes along the principal axis of the colors. */
+void EncodeBC1(const FColor* Block, uint8* Out)
+{
+	FVector Colors[BLOCK_PIXELS];
+	FVector Mean = FVector::ZeroVector;
+	for (int32 Index = 0; Index < BLOCK_PIXELS; ++Index)
+	{
+		Colors[Index] = FVector(Block[Index].R, Block[Index].G, Block[Index].B);
+		Mean += Colors[Index];
+	}
+	Mean /= BLOCK_PIXELS;
+
+	// Covariance matrix (symmetric, therefore only 6 entries: RR, RG, RB, GG, GB, BB)
+	float Covariance[6] = {};
+	for (const FVector& Color : Colors)
+	{
+		const FVector Delta = Color - Mean;
+		Covariance[0] += Delta.X * Delta.X;
+		Covariance[1] += Delta.X * Delta.Y;
+		Covariance[2] += Delta.X * Delta.Z;
+		Covariance[3] += Delta.Y * Delta.Y;
+		Covariance[4] += Delta.Y * Delta.Z;
+		Covariance[5] += Delta.Z * Delta.Z;
+	}
+
+	// A few power iterations are enough to approximate the principal axis
+	FVector Axis(1.0f, 1.0f, 1.0f);
+	for (int32 Iteration = 0; Iteration < 4; ++Iteration)
+	{
+		const FVector Next(Covariance[0] * Axis.X + Covariance[1] * Axis.Y + Covariance[2] * Axis.Z,
+						   Covariance[1] * Axis.X + Covariance[3] * Axis.Y + Covariance[4] * Axis.Z,
+						   Covariance[2] * Axis.X + Covariance[4] * Axis.Y + Covariance[5] * Axis.Z);
+		if (Next.SizeSquared() < KINDA_SMALL_NUMBER)
+		{
+			break;
+		}
+		Axis = Next.GetUnsafeNormal();
+	}
+
+	FVector MinColor = Colors[0];
+	FVector MaxColor = Colors[0];
+	float MinProjection = TNumericLimits<float>::Max();
+	float MaxProjection = TNumericLimits<float>::Lowest();
+	for (const FVector& Color : Colors)
+	{
+		const float Projection = FVector::DotProduct(Color - Mean, Axis);
+		if (Projection < MinProjection)
+		{
+			MinProjection = Projection;
+			MinColor = Color;
+		}
+		if (Projection > MaxProjection)
+		{
+			MaxProjection = Projection;
+			MaxColor = Color;
+		}
+	}
+
+	// The first endpoint has to be larger to select the four color mode
+	uint16 Color0 = ToRGB565(MaxColor);
+	uint16 Color1 = ToRGB565(MinColor);
+	if (Color0 < Color1)
+	{
+		Swap(Color0, Color1);
+	}
+	WriteUInt16(Color0, Out);
+	WriteUInt16(Color1, Out + 2);
+
+	uint32 Indices = 0;
+	if (Color0 != Color1)
+	{
+		const FVector Endpoint0 = FromRGB565(Color0);
+		const FVector Endpoint1 = FromRGB565(Color1);
+		const FVector Palette[4] = {Endpoint0, Endpoint1, (2.0f * Endpoint0 + Endpoint1) / 3.0f, (Endpoint0 + 2.0f * Endpoint1) / 3.0f};
+		for (int32 Index = 0; Index < BLOCK_PIXELS; ++Index)
+		{
+			uint32 BestIndex = 0;
+			float BestDistance = TNumericLimits<float>::Max();
+			for (uint32 PaletteIndex = 0; PaletteIndex < 4; ++PaletteIndex)
+			{
+				const float Distance = FVector::DistSquared(Colors[Index], Palette[PaletteIndex]);
+				if (Distance < BestDistance)
+				{
+					BestDistance = Distance;
+					BestIndex = PaletteIndex;
+				}
+			}
+			Indices |= BestIndex << (2 * Index);
+		}
+	}
+
+	for (int32 Byte = 0; Byte < 4; ++Byte)
+	{
+		Out[4 + Byte] = static_cast<uint8>((Indices >> (8 * Byte)) & 0xFF);
+	}
+}
+
+/** Encodes 16 single channel values into 8 bytes of BC4 using the eight value mode between the minimum and maximum value. */
+void EncodeBC4(const uint8* Values, uint8* Out)
+{
+	uint8 MinValue = Values[0];
+	uint8 MaxValue = Values[0];
+	for (int32 Index = 1; Index < BLOCK_PIXELS; ++Index)
+	{
+		MinValue = FMath::Min(MinValue, Values[Index]);
+		MaxValue = FMath::Max(MaxValue, Values[Index]);
+	}
+
+	Out[0] = MaxValue;
+	Out[1] = MinValue;
+
+	uint64 Indices = 0;
+	if (MaxValue != MinValue)
+	{
+		float Palette[8];
+		Palette[0] = MaxValue;
+		Palette[1] = MinValue;
+		for (int32 Step = 1; Step < 7; ++Step)
+		{
+			Palette[Step + 1] = ((7 - Step) * MaxValue + Step * MinValue) / 7.0f;
+		}
+
+		for (int32 Index = 0; Index < BLOCK_PIXELS; ++Index)
+		{
+			uint64 BestIndex = 0;
+			float BestDistance = TNumericLimits<float>::Max();
+			for (uint64 PaletteIndex = 0; PaletteIndex < 8; ++PaletteIndex)
+			{
+				const float Distance = FMath::Abs(Values[Index] - Palette[PaletteIndex]);
+				if (Distance < BestDistance)
+				{
+					BestDistance = Distance;
+					BestIndex = PaletteIndex;
+				}
+			}
+			Indices |= BestIndex << (3 * Index);
+		}
+	}
+
+	for (int32 Byte = 0; Byte < 6; ++Byte)
+	{
+		Out[2 + Byte] = static_cast<uint8>((Indices >> (8 * Byte)) & 0xFF);
+	}
+}
+
+template <typename F>
+void ExtractChannel(const FColor* Block, uint8* OutValues, F Accessor)
+{
+	for (int32 Index = 0; Index < BLOCK_PIXELS; ++Index)
+	{
+		OutValues[Index] = Accessor(Block[Index]);
+	}
+}
+
+void EncodeBlock(const FColor* Block, EPixelFormat PixelFormat, uint8* Out)
+{
+	uint8 Values[BLOCK_PIXELS];
+	switch (PixelFormat)
+	{
+	case PF_DXT1:
+		EncodeBC1(Block, Out);
+		break;
+	case PF_DXT5:
+		ExtractChannel(Block, Values, [](const FColor& Color) { return Color.A; });
+		EncodeBC4(Values, Out);
+		EncodeBC1(Block, Out + 8);
+		break;
+	case PF_BC4:
+		ExtractChannel(Block, Values, [](const FColor& Color) { return Color.R; });
+		EncodeBC4(Values, Out);
+		break;
+	case PF_BC5:
+		ExtractChannel(Block, Values, [](const FColor& Color) { return Color.R; });
+		EncodeBC4(Values, Out);
+		ExtractChannel(Block, Values, [](const FColor& Color) { return Color.G; });
+		EncodeBC4(Values, Out + 8);
+		break;
+	default:
+		checkNoEntry();
+	}
+}
+} // namespace
+
+namespace Vitruvio
+{
+TArray<TArray<FColor>> GenerateMipChain(const FColor* Pixels, int32 SizeX, int32 SizeY, bool bSRGB)
+{
+	TArray<TArray<FColor>> Mips;
+	Mips.Emplace(Pixels, SizeX * SizeY);
+
+	int32 MipSizeX = SizeX;
+	int32 MipSizeY = SizeY;
+	while (MipSizeX > 1 || MipSizeY > 1)
+	{
+		const int32 NextSizeX = FMath::Max(1, MipSizeX / 2);
+		const int32 NextSizeY = FMath::Max(1, MipSizeY / 2);
+
+		TArray<FColor> Next;
+		Next.SetNumUninitialized(NextSizeX * NextSizeY);
+		const FColor* Source = Mips.Last().GetData();
+		ParallelFor(NextSizeY, [&](int32 Y) {
+			const int32 Y0 = FMath::Min(2 * Y, MipSizeY - 1);
+			const int32 Y1 = FMath::Min(2 * Y + 1, MipSizeY - 1);
+			for (int32 X = 0; X < NextSizeX; ++X)
+			{
+				const int32 X0 = FMath::Min(2 * X, MipSizeX - 1);
+				const int32 X1 = FMath::Min(2 * X + 1, MipSizeX - 1);
+				const FColor& C00 = Source[Y0 * MipSizeX + X0];
+				const FColor& C01 = Source[Y0 * MipSizeX + X1];
+				const FColor& C10 = Source[Y1 * MipSizeX + X0];
+				const FColor& C11 = Source[Y1 * MipSizeX + X1];
+
+				FColor& Target = Next[Y * NextSizeX + X];
+				if (bSRGB)
+				{
+					// FLinearColor converts from sRGB, ToFColor back to sRGB (alpha is linear in both cases)
+					const FLinearColor Average = (FLinearColor(C00) + FLinearColor(C01) + FLinearColor(C10) + FLinearColor(C11)) * 0.25f;
+					Target = Average.ToFColor(true);
+				}
+				else
+				{
+					Target.R = static_cast<uint8>((C00.R + C01.R + C10.R + C11.R + 2) / 4);
+					Target.G = static_cast<uint8>((C00.G + C01.G + C10.G + C11.G + 2) / 4);
+					Target.B = static_cast<uint8>((C00.B + C01.B + C10.B + C11.B + 2) / 4);
+					Target.A = static_cast<uint8>((C00.A + C01.A + C10.A + C11.A + 2) / 4);
+				}
+			}
+		});
+
+		Mips.Add(MoveTemp(Next));
+		MipSizeX = NextSizeX;
+		MipSizeY = NextSizeY;
+	}
+
+	return Mips;
+}
+
+bool CanBlockCompress(int32 SizeX, int32 SizeY)
+{
+	return SizeX > 0 && SizeY > 0 && SizeX % BLOCK_SIZE == 0 && SizeY % BLOCK_SIZE == 0;
+}
+
+TArray<uint8> CompressImage(const FColor* Pixels, int32 SizeX, int32 SizeY, EPixelFormat PixelFormat)
+{
+	check(PixelFormat == PF_DXT1 || PixelFormat == PF_DXT5 || PixelFormat == PF_BC4 || PixelFormat == PF_BC5);
+
+	const int32 BlockBytes = GPixelFormats[PixelFormat].BlockBytes;
+	const int32 NumBlocksX = FMath::DivideAndRoundUp(SizeX, BLOCK_SIZE);
+	const int32 NumBlocksY = FMath::DivideAndRoundUp(SizeY, BLOCK_SIZE);
+
+	TArray<uint8> Compressed;
+	Compressed.SetNumUninitialized(NumBlocksX * NumBlocksY * BlockBytes);
+	ParallelFor(NumBlocksY, [&](int32 BlockY) {
+		FColor Block[BLOCK_PIXELS];
+		for (int32 BlockX = 0; BlockX < NumBlocksX; ++BlockX)
+		{
+			// Pixels outside of the image (only for mips smaller than a block) repeat the border pixels
+			for (int32 Y = 0; Y < BLOCK_SIZE; ++Y)
+			{
+				const int32 SourceY = FMath::Min(BlockY * BLOCK_SIZE + Y, SizeY - 1);
+				for (int32 X = 0; X < BLOCK_SIZE; ++X)
+				{
+					const int32 SourceX = FMath::Min(BlockX * BLOCK_SIZE + X, SizeX - 1);
+					Block[Y * BLOCK_SIZE + X] = Pixels[SourceY * SizeX + SourceX];
+				}
+			}
+			EncodeBlock(Block, PixelFormat, Compressed.GetData() + (BlockY * NumBlocksX + BlockX) * BlockBytes);
+		}
+	});
+
+	return Compressed;
+}
+} // namespace Vitruvio
@@ -0,0 +1,37 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+
+namespace Vitruvio
+{
+/**
+ * Generates the full mip chain (down to 1x1) of BGRA8 image data by 2x2 box filtering, the first mip is a copy of the given image. Color
+ * channels of sRGB images are filtered in linear space. Can be called from any thread.
+ */
+TArray<TArray<FColor>> GenerateMipChain(const FColor* Pixels, int32 SizeX, int32 SizeY, bool bSRGB);
+
+/** Returns whether images of the given size can be block compressed (the size of the first mip has to be a multiple of the block size). */
+bool CanBlockCompress(int32 SizeX, int32 SizeY);
+
+/**
+ * Block compresses BGRA8 image data. Supported are PF_DXT1 (BC1, RGB), PF_DXT5 (BC3, RGBA), PF_BC4 (R) and PF_BC5 (RG). Images smaller
+ * than a block are padded by repeating their border pixels. Can be called from any thread.
+ */
+TArray<uint8> CompressImage(const FColor* Pixels, int32 SizeX, int32 SizeY, EPixelFormat PixelFormat);
+} // namespace Vitruvio
@@ -18,11 +18,14 @@
 #include "AttributeConversion.h"
 #include "GeneratedModelHISMComponent.h"
 #include "GeneratedModelStaticMeshComponent.h"
+#include "MaterialCache.h"
 #include "MaterialConversion.h"
 #include "UnrealCallbacks.h"
 #include "VitruvioModule.h"
+#include "VitruvioSettings.h"
 #include "VitruvioTypes.h"
 
+#include "Algo/AllOf.h"
 #include "Components/HierarchicalInstancedStaticMeshComponent.h"
 #include "Components/SplineComponent.h"
 #include "Engine/CollisionProfile.h"
@@ -31,6 +34,9 @@
 #include "PhysicsEngine/BodySetup.h"
 #include "PolygonWindings.h"
 #include "StaticMeshAttributes.h"
+#include "StaticMeshBuilder.h"
+#include "StaticMeshRegistry.h"
+#include "TextureCache.h"
 
 #if WITH_EDITOR
 #include "DetailLayoutBuilder.h"
@@ -75,7 +81,7 @@ bool GetAttribute(const TMap<FString, URuleAttribute*>& Attributes, const FStrin
 }
 
 template <typename A, typename T>
-bool SetAttribute(UVitruvioComponent* VitruvioComponent, TMap<FString, URuleAttribute*>& Attributes, const FString& Name, const T& Value)
+bool SetAttribute(TMap<FString, URuleAttribute*>& Attributes, const FString& Name, const T& Value)
 {
 	URuleAttribute** FoundAttribute = Attributes.Find(Name);
 	if (!FoundAttribute)
@@ -91,14 +97,33 @@ bool SetAttribute(UVitruvioComponent* VitruvioComponent, TMap<FString, URuleAttr
 	}
 
 	TAttribute->Value = Value;
-	if (VitruvioComponent->GenerateAutomatically && VitruvioComponent->IsReadyToGenerate())
+
+	return true;
+}
+
+template <typename A, typename T>
+bool CanSetAttributeValues(const TMap<FString, URuleAttribute*>& Attributes, const TMap<FString, T>& Values)
+{
+	for (const auto& Value : Values)
 	{
-		VitruvioComponent->Generate();
+		URuleAttribute* const* FoundAttribute = Attributes.Find(Value.Key);
+		if (!FoundAttribute || !Cast<A>(*FoundAttribute))
+		{
+			return false;
+		}
 	}
-
 	return true;
 }
 
+template <typename A, typename T>
+void SetAttributeValues(TMap<FString, URuleAttribute*>& Attributes, const TMap<FString, T>& Values)
+{
+	for (const auto& Value : Values)
+	{
+		SetAttribute<A, T>(Attributes, Value.Key, Value.Value);
+	}
+}
+
 bool IsOuterOf(UObject* Inner, UObject* Outer)
 {
 	if (!Outer)
@@ -121,28 +146,30 @@ bool IsOuterOf(UObject* Inner, UObject* Outer)
 	return false;
 }
 
-void InitializeBodySetup(UBodySetup* BodySetup, bool GenerateComplexCollision)
+void ReleaseResources(TArray<UStaticMesh*>& Meshes, TArray<UMaterialInstanceDynamic*>& Materials)
 {
-	BodySetup->DefaultInstance.SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
-	BodySetup->CollisionTraceFlag =
-		GenerateComplexCollision ? ECollisionTraceFlag::CTF_UseComplexAsSimple : ECollisionTraceFlag::CTF_UseSimpleAsComplex;
-	BodySetup->bDoubleSidedGeometry = true;
-	BodySetup->bMeshCollideAll = true;
-	BodySetup->InvalidatePhysicsData();
-	BodySetup->CreatePhysicsMeshes();
-}
+	Vitruvio::FStaticMeshRegistry& StaticMeshRegistry = VitruvioModule::Get().GetStaticMeshRegistry();
+	Vitruvio::FMaterialCache& MaterialCache = VitruvioModule::Get().GetMaterialCache();
 
-void CreateCollision(UStaticMesh* Mesh, UStaticMeshComponent* StaticMeshComponent, bool ComplexCollision)
-{
-	if (!Mesh)
+	for (UStaticMesh* Mesh : Meshes)
 	{
-		return;
+		// The materials of a mesh are used as long as the mesh is shared through the registry
+		if (StaticMeshRegistry.Release(Mesh))
+		{
+			for (const FStaticMaterial& StaticMaterial : Mesh->StaticMaterials)
+			{
+				MaterialCache.Release(StaticMaterial.MaterialInterface);
+			}
+		}
+	}
+
+	for (UMaterialInstanceDynamic* Material : Materials)
+	{
+		MaterialCache.Release(Material);
 	}
 
-	UBodySetup* BodySetup = NewObject<UBodySetup>(StaticMeshComponent);
-	InitializeBodySetup(BodySetup, ComplexCollision);
-	Mesh->BodySetup = BodySetup;
-	StaticMeshComponent->RecreatePhysicsState();
+	Meshes.Empty();
+	Materials.Empty();
 }
 
 #if WITH_EDITOR
@@ -218,13 +245,21 @@ void UVitruvioComponent::SetRpk(URulePackage* RulePackage)
 	this->Rpk = RulePackage;
 
 	Attributes.Empty();
+	AttributeMapBuilderCache.Reset();
+	ResetAttributeSchema();
 	bAttributesReady = false;
 	bNotifyAttributeChange = true;
 }
 
 bool UVitruvioComponent::SetStringAttribute(const FString& Name, const FString& Value)
 {
-	return SetAttribute<UStringAttribute, FString>(this, this->Attributes, Name, Value);
+	if (!SetAttribute<UStringAttribute, FString>(this->Attributes, Name, Value))
+	{
+		return false;
+	}
+
+	OnAttributeValuesChanged();
+	return true;
 }
 
 bool UVitruvioComponent::GetStringAttribute(const FString& Name, FString& OutValue) const
@@ -234,7 +269,13 @@ bool UVitruvioComponent::GetStringAttribute(const FString& Name, FString& OutVal
 
 bool UVitruvioComponent::SetBoolAttribute(const FString& Name, bool Value)
 {
-	return SetAttribute<UBoolAttribute, bool>(this, this->Attributes, Name, Value);
+	if (!SetAttribute<UBoolAttribute, bool>(this->Attributes, Name, Value))
+	{
+		return false;
+	}
+
+	OnAttributeValuesChanged();
+	return true;
 }
 
 bool UVitruvioComponent::GetBoolAttribute(const FString& Name, bool& OutValue) const
@@ -244,7 +285,13 @@ bool UVitruvioComponent::GetBoolAttribute(const FString& Name, bool& OutValue) c
 
 bool UVitruvioComponent::SetFloatAttribute(const FString& Name, float Value)
 {
-	return SetAttribute<UFloatAttribute, float>(this, this->Attributes, Name, Value);
+	if (!SetAttribute<UFloatAttribute, float>(this->Attributes, Name, Value))
+	{
+		return false;
+	}
+
+	OnAttributeValuesChanged();
+	return true;
 }
 
 bool UVitruvioComponent::GetFloatAttribute(const FString& Name, float& OutValue) const
@@ -252,6 +299,65 @@ bool UVitruvioComponent::GetFloatAttribute(const FString& Name, float& OutValue)
 	return GetAttribute<UFloatAttribute, float>(this->Attributes, Name, OutValue);
 }
 
+bool UVitruvioComponent::SetAttributes(const TMap<FString, float>& FloatValues, const TMap<FString, FString>& StringValues,
+									   const TMap<FString, bool>& BoolValues)
+{
+	// All values are validated first so that either all or none of them are applied
+	if (!CanSetAttributeValues<UFloatAttribute, float>(Attributes, FloatValues) ||
+		!CanSetAttributeValues<UStringAttribute, FString>(Attributes, StringValues) ||
+		!CanSetAttributeValues<UBoolAttribute, bool>(Attributes, BoolValues))
+	{
+		return false;
+	}
+
+	SetAttributeValues<UFloatAttribute, float>(Attributes, FloatValues);
+	SetAttributeValues<UStringAttribute, FString>(Attributes, StringValues);
+	SetAttributeValues<UBoolAttribute, bool>(Attributes, BoolValues);
+
+	if (FloatValues.Num() + StringValues.Num() + BoolValues.Num() > 0)
+	{
+		OnAttributeValuesChanged();
+	}
+
+	return true;
+}
+
+void UVitruvioComponent::BeginAttributeUpdate()
+{
+	++AttributeUpdateDepth;
+}
+
+void UVitruvioComponent::CommitAttributeUpdate()
+{
+	if (AttributeUpdateDepth == 0)
+	{
+		UE_LOG(LogUnrealPrt, Warning, TEXT("CommitAttributeUpdate called without a matching BeginAttributeUpdate on %s"), *GetName());
+		return;
+	}
+
+	--AttributeUpdateDepth;
+	if (AttributeUpdateDepth == 0 && bAttributeUpdatePending)
+	{
+		bAttributeUpdatePending = false;
+		OnAttributeValuesChanged();
+	}
+}
+
+void UVitruvioComponent::OnAttributeValuesChanged()
+{
+	// Inside of an attribute update the generate is deferred until the outermost CommitAttributeUpdate
+	if (AttributeUpdateDepth > 0)
+	{
+		bAttributeUpdatePending = true;
+		return;
+	}
+
+	if (GenerateAutomatically && IsReadyToGenerate())
+	{
+		Generate();
+	}
+}
+
 const TMap<FString, URuleAttribute*>& UVitruvioComponent::GetAttributes() const
 {
 	return Attributes;
@@ -267,10 +373,7 @@ void UVitruvioComponent::SetRandomSeed(int32 NewRandomSeed)
 	RandomSeed = NewRandomSeed;
 	bValidRandomSeed = true;
 
-	if (GenerateAutomatically && IsReadyToGenerate())
-	{
-		Generate();
-	}
+	OnAttributeValuesChanged();
 }
 
 void UVitruvioComponent::LoadInitialShape()
@@ -321,6 +424,12 @@ void UVitruvioComponent::Initialize()
 
 	CalculateRandomSeed();
 
+	// Annotations are shared between all components using the rule package and are not saved with the attributes
+	if (bAttributesReady && Rpk && !AttributeSchema)
+	{
+		LoadAttributeSchema();
+	}
+
 	// Check if we can load the attributes and then generate (eg during play)
 	if (GenerateAutomatically && IsReadyToGenerate())
 	{
@@ -352,85 +461,169 @@ void UVitruvioComponent::OnComponentCreated()
 
 void UVitruvioComponent::ProcessGenerateQueue()
 {
-	if (!GenerateQueue.IsEmpty())
+	if (GenerateQueue.IsEmpty())
 	{
-		// Get from queue and build meshes
-		FGenerateResultDescription Result;
-		GenerateQueue.Dequeue(Result);
+		return;
+	}
 
-		FConvertedGenerateResult ConvertedResult =
-			BuildResult(Result, VitruvioModule::Get().GetMaterialCache(), VitruvioModule::Get().GetTextureCache());
+	// Only the most recent result has to be applied, an older result which is still being applied is discarded. Canceled results only
+	// release the generate token so that the pending generate request can be dispatched.
+	FGenerateResult::ResultType Completed;
+	FGenerateResultDescription Result;
+	bool bHasResult = false;
+	while (GenerateQueue.Dequeue(Completed))
+	{
+		if (Completed.Token == GenerateToken)
+		{
+			GenerateToken.Reset();
+		}
+		if (!Completed.Token->IsCanceled())
+		{
+			Result = MoveTemp(Completed.Value);
+			bHasResult = true;
+		}
+	}
 
-		QUICK_SCOPE_CYCLE_COUNTER(STAT_VitruvioActor_CreateModelActors);
+	if (!bHasResult)
+	{
+		return;
+	}
 
-		USceneComponent* InitialShapeComponent = InitialShape->GetComponent();
-		UGeneratedModelStaticMeshComponent* VitruvioModelComponent = nullptr;
+	ResetApplyState();
+	ApplyState = MakeUnique<FApplyState>();
+	ApplyState->Result = MoveTemp(Result);
 
-		TArray<USceneComponent*> InitialShapeChildComponents;
-		InitialShapeComponent->GetChildrenComponents(false, InitialShapeChildComponents);
-		for (USceneComponent* Component : InitialShapeChildComponents)
-		{
-			if (Component->IsA(UGeneratedModelStaticMeshComponent::StaticClass()))
-			{
-				VitruvioModelComponent = Cast<UGeneratedModelStaticMeshComponent>(Component);
+	// The result is applied in steps spread over multiple frames (see ApplyNextStep)
+	VitruvioModule::Get().ScheduleApply(this);
+}
 
-				VitruvioModelComponent->SetStaticMesh(nullptr);
+FVector UVitruvioComponent::GetApplyLocation() const
+{
+	if (InitialShape && InitialShape->GetComponent())
+	{
+		return InitialShape->GetComponent()->GetComponentLocation();
+	}
+	return GetOwner() ? GetOwner()->GetActorLocation() : FVector::ZeroVector;
+}
+
+EApplyStepResult UVitruvioComponent::ApplyNextStep()
+{
+	if (!ApplyState || !InitialShape)
+	{
+		ResetApplyState();
+		return EApplyStepResult::Finished;
+	}
 
-				// Cleanup old hierarchical instances
-				TArray<USceneComponent*> InstanceComponents;
-				VitruvioModelComponent->GetChildrenComponents(true, InstanceComponents);
-				for (USceneComponent* InstanceComponent : InstanceComponents)
+	switch (ApplyState->Step)
+	{
+	case EApplyStep::LoadTextures:
+	{
+		if (!ApplyState->bTexturesRequested)
+		{
+			ApplyState->bTexturesRequested = true;
+
+			Vitruvio::FMaterialCache& MaterialCache = VitruvioModule::Get().GetMaterialCache();
+			Vitruvio::FTextureCache& TextureCache = VitruvioModule::Get().GetTextureCache();
+			auto RequestTextures = [this, &MaterialCache, &TextureCache](const TArray<Vitruvio::FMaterialAttributeContainer>& Materials) {
+				for (const Vitruvio::FMaterialAttributeContainer& Material : Materials)
 				{
-					InstanceComponent->DestroyComponent(true);
+					if (MaterialCache.Contains(Material))
+					{
+						continue;
+					}
+					for (const auto& TextureProperty : Material.TextureProperties)
+					{
+						if (!TextureProperty.Value.IsEmpty())
+						{
+							ApplyState->PendingTextures.Add(TextureCache.LoadAsync(TextureProperty.Value, TextureProperty.Key));
+							ApplyState->TexturePaths.Add(TextureProperty.Value);
+						}
+					}
 				}
+			};
 
-				break;
+			for (const auto& IdAndMesh : ApplyState->Result.Meshes)
+			{
+				RequestTextures(IdAndMesh.Value->Materials);
+			}
+			for (const auto& Instance : ApplyState->Result.Instances)
+			{
+				RequestTextures(Instance.Key.MaterialOverrides);
 			}
 		}
 
-		if (!VitruvioModelComponent)
+		// The materials are only created once all their textures are loaded, so that creating them never blocks the game thread
+		const bool bTexturesLoaded = Algo::AllOf(ApplyState->PendingTextures, [](const TSharedFuture<Vitruvio::FTextureData>& Texture) {
+			return Texture.IsReady();
+		});
+		if (!bTexturesLoaded)
 		{
-			VitruvioModelComponent = NewObject<UGeneratedModelStaticMeshComponent>(InitialShape->GetComponent(), FName(TEXT("GeneratedModel")),
-																				   RF_Transient | RF_DuplicateTransient);
-			VitruvioModelComponent->AttachToComponent(InitialShapeComponent, FAttachmentTransformRules::KeepRelativeTransform);
-			InitialShapeComponent->GetOwner()->AddInstanceComponent(VitruvioModelComponent);
-			VitruvioModelComponent->OnComponentCreated();
-			VitruvioModelComponent->RegisterComponent();
+			return EApplyStepResult::Waiting;
 		}
 
-		VitruvioModelComponent->SetStaticMesh(ConvertedResult.ShapeMesh);
-		VitruvioModelComponent->SetCollisionData(ConvertedResult.CollisionData);
+		ApplyState->PendingTextures.Empty();
+		ApplyState->Step = EApplyStep::BuildMeshes;
+		return EApplyStepResult::Continue;
+	}
+	case EApplyStep::BuildMeshes:
+	{
+		ApplyState->ConvertedResult =
+			BuildResult(ApplyState->Result, VitruvioModule::Get().GetMaterialCache(), VitruvioModule::Get().GetTextureCache());
 
-		CreateCollision(ConvertedResult.ShapeMesh, VitruvioModelComponent, GenerateCollision);
+		// The created materials hold their own texture references now
+		ReleaseApplyTextures();
 
-		for (const FInstance& Instance : ConvertedResult.Instances)
+		ApplyState->Step = EApplyStep::PrepareModel;
+		return EApplyStepResult::Continue;
+	}
+	case EApplyStep::PrepareModel:
+	{
+		ApplyState->StaleInstanceComponents.Empty();
+		ApplyState->ModelComponent = PrepareModelComponent(ApplyState->ConvertedResult, ApplyState->StaleInstanceComponents);
+		ApplyState->Step = EApplyStep::CreateInstances;
+		return EApplyStepResult::Continue;
+	}
+	case EApplyStep::CreateInstances:
+	{
+		// The model component might have been destroyed in the meantime (eg. by undo)
+		if (!ApplyState->ModelComponent.IsValid())
+		{
+			ApplyState->NextInstanceIndex = 0;
+			ApplyState->Step = EApplyStep::PrepareModel;
+			return EApplyStepResult::Continue;
+		}
+
+		if (ApplyState->NextInstanceIndex < ApplyState->ConvertedResult.Instances.Num())
 		{
-			auto InstancedComponent =
-				NewObject<UGeneratedModelHISMComponent>(VitruvioModelComponent, NAME_None, RF_Transient | RF_DuplicateTransient);
-			const TArray<FTransform>& Transforms = Instance.Transforms;
-			InstancedComponent->SetStaticMesh(Instance.Mesh);
-			InstancedComponent->SetCollisionData(Instance.CollisionData);
-
-			// Add all instance transforms
-			for (const FTransform& Transform : Transforms)
+			const FInstance& Instance = ApplyState->ConvertedResult.Instances[ApplyState->NextInstanceIndex++];
+
+			// Reuse an instance component of the previous result which holds the same mesh and materials
+			const TWeakObjectPtr<UGeneratedModelHISMComponent> ReusableComponent = ApplyState->StaleInstanceComponents.FindRef(Instance.Key);
+			ApplyState->StaleInstanceComponents.RemoveSingle(Instance.Key, ReusableComponent);
+			if (ReusableComponent.IsValid())
 			{
-				InstancedComponent->AddInstance(Transform);
+				UpdateInstanceComponent(ReusableComponent.Get(), Instance);
 			}
-
-			// Apply override materials
-			for (int32 MaterialIndex = 0; MaterialIndex < Instance.OverrideMaterials.Num(); ++MaterialIndex)
+			else
 			{
-				InstancedComponent->SetMaterial(MaterialIndex, Instance.OverrideMaterials[MaterialIndex]);
+				CreateInstanceComponent(ApplyState->ModelComponent.Get(), Instance);
 			}
+			return EApplyStepResult::Continue;
+		}
 
-			// Instanced component collision
-			CreateCollision(Instance.Mesh, InstancedComponent, GenerateCollision);
-
-			// Attach and register instance component
-			InstancedComponent->AttachToComponent(VitruvioModelComponent, FAttachmentTransformRules::KeepRelativeTransform);
-			InitialShapeComponent->GetOwner()->AddInstanceComponent(InstancedComponent);
-			InstancedComponent->OnComponentCreated();
-			InstancedComponent->RegisterComponent();
+		ApplyState->Step = EApplyStep::Finalize;
+		return EApplyStepResult::Continue;
+	}
+	case EApplyStep::Finalize:
+	default:
+	{
+		// Destroy the instance components which are not part of the new result anymore
+		for (const auto& KeyAndComponent : ApplyState->StaleInstanceComponents)
+		{
+			if (KeyAndComponent.Value.IsValid())
+			{
+				KeyAndComponent.Value->DestroyComponent(true);
+			}
 		}
 
 		OnHierarchyChanged.Broadcast(this);
@@ -438,6 +631,167 @@ void UVitruvioComponent::ProcessGenerateQueue()
 		HasGeneratedMesh = true;
 
 		InitialShape->SetHidden(HideAfterGeneration);
+
+		// The meshes and materials of the previous result are released only now, the ones used by both results are therefore kept
+		ReleaseAppliedResources();
+		AppliedMeshes = MoveTemp(ApplyState->ConvertedResult.Meshes);
+		AppliedMaterials = MoveTemp(ApplyState->ConvertedResult.Materials);
+
+		ApplyState.Reset();
+		return EApplyStepResult::Finished;
+	}
+	}
+}
+
+void UVitruvioComponent::ResetApplyState()
+{
+	if (ApplyState)
+	{
+		ReleaseApplyTextures();
+		ReleaseResources(ApplyState->ConvertedResult.Meshes, ApplyState->ConvertedResult.Materials);
+		ApplyState.Reset();
+	}
+}
+
+void UVitruvioComponent::ReleaseApplyTextures()
+{
+	Vitruvio::FTextureCache& TextureCache = VitruvioModule::Get().GetTextureCache();
+	for (const FString& TexturePath : ApplyState->TexturePaths)
+	{
+		TextureCache.Release(TexturePath);
+	}
+	ApplyState->TexturePaths.Empty();
+	ApplyState->PendingTextures.Empty();
+}
+
+void UVitruvioComponent::ReleaseAppliedResources()
+{
+	ReleaseResources(AppliedMeshes, AppliedMaterials);
+}
+
+UGeneratedModelStaticMeshComponent* UVitruvioComponent::FindModelComponent() const
+{
+	TArray<USceneComponent*> InitialShapeChildComponents;
+	InitialShape->GetComponent()->GetChildrenComponents(false, InitialShapeChildComponents);
+	for (USceneComponent* Component : InitialShapeChildComponents)
+	{
+		if (Component->IsA(UGeneratedModelStaticMeshComponent::StaticClass()))
+		{
+			return Cast<UGeneratedModelStaticMeshComponent>(Component);
+		}
+	}
+	return nullptr;
+}
+
+UGeneratedModelStaticMeshComponent* UVitruvioComponent::PrepareModelComponent(
+	const FConvertedGenerateResult& ConvertedResult, TMultiMap<FSHAHash, TWeakObjectPtr<UGeneratedModelHISMComponent>>& OutInstanceComponents)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_VitruvioActor_CreateModelActors);
+
+	USceneComponent* InitialShapeComponent = InitialShape->GetComponent();
+	UGeneratedModelStaticMeshComponent* VitruvioModelComponent = FindModelComponent();
+
+	if (VitruvioModelComponent)
+	{
+		// Collect the existing instance components, they are reused if the new result contains the same instances
+		TArray<USceneComponent*> InstanceComponents;
+		VitruvioModelComponent->GetChildrenComponents(true, InstanceComponents);
+		for (USceneComponent* InstanceComponent : InstanceComponents)
+		{
+			UGeneratedModelHISMComponent* InstancedComponent = Cast<UGeneratedModelHISMComponent>(InstanceComponent);
+			if (InstancedComponent)
+			{
+				OutInstanceComponents.Add(InstancedComponent->GetInstanceKey(), InstancedComponent);
+			}
+			else
+			{
+				InstanceComponent->DestroyComponent(true);
+			}
+		}
+	}
+	else
+	{
+		VitruvioModelComponent = NewObject<UGeneratedModelStaticMeshComponent>(InitialShape->GetComponent(), FName(TEXT("GeneratedModel")),
+																			   RF_Transient | RF_DuplicateTransient);
+		VitruvioModelComponent->AttachToComponent(InitialShapeComponent, FAttachmentTransformRules::KeepRelativeTransform);
+		InitialShapeComponent->GetOwner()->AddInstanceComponent(VitruvioModelComponent);
+		VitruvioModelComponent->OnComponentCreated();
+		VitruvioModelComponent->RegisterComponent();
+	}
+
+	// The static mesh is shared through the static mesh registry and therefore the same if the shape geometry did not change
+	if (VitruvioModelComponent->GetStaticMesh() != ConvertedResult.ShapeMesh)
+	{
+		VitruvioModelComponent->SetStaticMesh(ConvertedResult.ShapeMesh);
+		VitruvioModelComponent->SetCollisionData(ConvertedResult.CollisionData);
+
+		VitruvioModule::Get().GetStaticMeshRegistry().CreateCollision(ConvertedResult.ShapeMesh, ConvertedResult.CollisionData,
+																	   VitruvioModelComponent);
+	}
+
+	return VitruvioModelComponent;
+}
+
+void UVitruvioComponent::CreateInstanceComponent(UGeneratedModelStaticMeshComponent* VitruvioModelComponent, const FInstance& Instance)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_VitruvioActor_CreateInstanceComponent);
+
+	USceneComponent* InitialShapeComponent = InitialShape->GetComponent();
+
+	auto InstancedComponent = NewObject<UGeneratedModelHISMComponent>(VitruvioModelComponent, NAME_None, RF_Transient | RF_DuplicateTransient);
+	InstancedComponent->SetStaticMesh(Instance.Mesh);
+	InstancedComponent->SetCollisionData(Instance.CollisionData);
+	InstancedComponent->SetInstanceKey(Instance.Key);
+
+	// Add all instance transforms at once, adding them one by one would update the instance bookkeeping (and the cluster tree) per transform
+	InstancedComponent->AddInstances(Instance.Transforms, false);
+
+	// Apply override materials
+	for (int32 MaterialIndex = 0; MaterialIndex < Instance.OverrideMaterials.Num(); ++MaterialIndex)
+	{
+		InstancedComponent->SetMaterial(MaterialIndex, Instance.OverrideMaterials[MaterialIndex]);
+	}
+
+	// Instanced component collision
+	VitruvioModule::Get().GetStaticMeshRegistry().CreateCollision(Instance.Mesh, Instance.CollisionData, InstancedComponent);
+
+	// Attach and register instance component
+	InstancedComponent->AttachToComponent(VitruvioModelComponent, FAttachmentTransformRules::KeepRelativeTransform);
+	InitialShapeComponent->GetOwner()->AddInstanceComponent(InstancedComponent);
+	InstancedComponent->OnComponentCreated();
+	InstancedComponent->RegisterComponent();
+}
+
+void UVitruvioComponent::UpdateInstanceComponent(UGeneratedModelHISMComponent* InstancedComponent, const FInstance& Instance)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_VitruvioActor_UpdateInstanceComponent);
+
+	// The mesh content is the same but a different static mesh is used if the collision setting changed
+	if (InstancedComponent->GetStaticMesh() != Instance.Mesh)
+	{
+		InstancedComponent->SetStaticMesh(Instance.Mesh);
+		InstancedComponent->SetCollisionData(Instance.CollisionData);
+		VitruvioModule::Get().GetStaticMeshRegistry().CreateCollision(Instance.Mesh, Instance.CollisionData, InstancedComponent);
+	}
+
+	const TArray<FTransform>& Transforms = Instance.Transforms;
+	if (InstancedComponent->GetInstanceCount() != Transforms.Num())
+	{
+		InstancedComponent->ClearInstances();
+		InstancedComponent->AddInstances(Transforms, false);
+		return;
+	}
+
+	// Update the transforms in place, only if at least one of them changed
+	for (int32 InstanceIndex = 0; InstanceIndex < Transforms.Num(); ++InstanceIndex)
+	{
+		FTransform CurrentTransform;
+		InstancedComponent->GetInstanceTransform(InstanceIndex, CurrentTransform);
+		if (!CurrentTransform.Equals(Transforms[InstanceIndex]))
+		{
+			InstancedComponent->BatchUpdateInstancesTransforms(0, Transforms, false, true);
+			return;
+		}
 	}
 }
 
@@ -465,6 +819,8 @@ void UVitruvioComponent::ProcessLoadAttributesQueue()
 			Attributes = LoadAttributes.AttributeMap->ConvertToUnrealAttributeMap(this);
 		}
 
+		AttributeMapBuilderCache.Reset();
+		AttributeSchema = LoadAttributes.AttributeMap->GetSchema();
 		bAttributesReady = true;
 
 		bNotifyAttributeChange = true;
@@ -476,10 +832,28 @@ void UVitruvioComponent::ProcessLoadAttributesQueue()
 	}
 }
 
+void UVitruvioComponent::ProcessAttributeSchemaQueue()
+{
+	TSharedPtr<const Vitruvio::FAttributeSchema> Schema;
+	while (AttributeSchemaQueue.Dequeue(Schema))
+	{
+	}
+
+	// Attributes which have been reloaded in the meantime already use the schema
+	if (Schema && !AttributeSchema)
+	{
+		AttributeSchema = Schema;
+		AttributeSchema->BindAttributes(Attributes);
+		bNotifyAttributeChange = true;
+	}
+}
+
 void UVitruvioComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	ProcessGenerateQueue();
 	ProcessLoadAttributesQueue();
+	ProcessAttributeSchemaQueue();
+	ProcessPendingGenerate();
 
 	if (bNotifyAttributeChange)
 	{
@@ -504,6 +878,10 @@ void UVitruvioComponent::RemoveGeneratedMeshes()
 		return;
 	}
 
+	// A result which is still being applied would otherwise recreate the meshes
+	ResetApplyState();
+	ReleaseAppliedResources();
+
 	USceneComponent* InitialShapeComponent = InitialShape->GetComponent();
 
 	TArray<USceneComponent*> Children;
@@ -517,113 +895,100 @@ void UVitruvioComponent::RemoveGeneratedMeshes()
 	InitialShape->SetHidden(false);
 }
 
-FConvertedGenerateResult UVitruvioComponent::BuildResult(FGenerateResultDescription& GenerateResult,
-														 TMap<Vitruvio::FMaterialAttributeContainer, UMaterialInstanceDynamic*>& MaterialCache,
-														 TMap<FString, Vitruvio::FTextureData>& TextureCache)
+FConvertedGenerateResult UVitruvioComponent::BuildResult(const FGenerateResultDescription& GenerateResult,
+														 Vitruvio::FMaterialCache& MaterialCache,
+														 Vitruvio::FTextureCache& TextureCache)
 {
-	TMap<int32, TTuple<UStaticMesh*, Vitruvio::FCollisionData>> MeshMap;
+	TMap<int32, TTuple<UStaticMesh*, Vitruvio::FGeneratedMeshPtr>> MeshMap;
+	Vitruvio::FStaticMeshRegistry& StaticMeshRegistry = VitruvioModule::Get().GetStaticMeshRegistry();
+	TArray<UStaticMesh*> AcquiredMeshes;
+	TArray<UMaterialInstanceDynamic*> AcquiredMaterials;
 
+	// Returns the material for the given attributes and acquires a reference to it which has to be released by the caller
 	auto CachedMaterial = [this, &MaterialCache, &TextureCache](const Vitruvio::FMaterialAttributeContainer& MaterialAttributes, const FName& Name,
 																UObject* Outer) {
-		if (MaterialCache.Contains(MaterialAttributes))
-		{
-			return MaterialCache[MaterialAttributes];
-		}
-		else
+		if (UMaterialInstanceDynamic* Material = MaterialCache.Acquire(MaterialAttributes))
 		{
-			UMaterialInstanceDynamic* Material = Vitruvio::GameThread_CreateMaterialInstance(Outer, Name, OpaqueParent, MaskedParent,
-																							 TranslucentParent, MaterialAttributes, TextureCache);
-			MaterialCache.Add(MaterialAttributes, Material);
 			return Material;
 		}
+
+		UMaterialInstanceDynamic* Material = Vitruvio::GameThread_CreateMaterialInstance(Outer, Name, OpaqueParent, MaskedParent,
+																						 TranslucentParent, MaterialAttributes, TextureCache);
+		MaterialCache.Add(MaterialAttributes, Material);
+		return Material;
 	};
 
-	// convert all meshes
-	for (auto& IdAndMesh : GenerateResult.MeshDescriptions)
+	// convert all meshes, the static meshes and their materials are created here and built in parallel afterwards
+	TArray<UStaticMesh*> StaticMeshes;
+	TArray<const FMeshDescription*> MeshDescriptions;
+	for (const auto& IdAndMesh : GenerateResult.Meshes)
 	{
-		UStaticMesh* StaticMesh = NewObject<UStaticMesh>(GetTransientPackage(), NAME_None, RF_Transient);
-		TMap<UMaterialInstanceDynamic*, FName> MaterialSlots;
-
-		const TArray<Vitruvio::FMaterialAttributeContainer>& MeshMaterials = GenerateResult.Materials[IdAndMesh.Key];
-		FMeshDescription& MeshDescription = IdAndMesh.Value;
-		FStaticMeshAttributes MeshAttributes(MeshDescription);
+		const Vitruvio::FGeneratedMesh& GeneratedMesh = *IdAndMesh.Value;
 
-		TArray<FVector> Vertices;
-		auto VertexPositions = MeshAttributes.GetVertexPositions();
-		for (int32 VertexIndex = 0; VertexIndex < VertexPositions.GetNumElements(); ++VertexIndex)
+		// Identical meshes (of this or any other component) share the same static mesh
+		if (UStaticMesh* SharedMesh = StaticMeshRegistry.Acquire(GeneratedMesh.ContentHash, GenerateCollision))
 		{
-			Vertices.Add(VertexPositions[FVertexID(VertexIndex)]);
+			AcquiredMeshes.Add(SharedMesh);
+			MeshMap.Add(IdAndMesh.Key, MakeTuple(SharedMesh, IdAndMesh.Value));
+			continue;
 		}
 
-		TArray<FTriIndices> Indices;
-		const auto PolygonGroups = MeshDescription.PolygonGroups();
-		size_t MaterialIndex = 0;
-		for (const auto& PolygonGroupId : PolygonGroups.GetElementIDs())
+		const FMeshDescription& MeshDescription = GeneratedMesh.MeshDescription;
+		UStaticMesh* StaticMesh = NewObject<UStaticMesh>(GetTransientPackage(), NAME_None, RF_Transient);
+
+		// The material slot names of the generated meshes are unique (see UnrealCallbacks::addMesh), we can therefore add one material
+		// slot per polygon group and build from the shared mesh description without modifying it
+		const TPolygonGroupAttributesConstRef<FName> MaterialSlotNames =
+			MeshDescription.PolygonGroupAttributes().GetAttributesRef<FName>(MeshAttribute::PolygonGroup::ImportedMaterialSlotName);
+		int32 MaterialIndex = 0;
+		for (const FPolygonGroupID PolygonGroupId : MeshDescription.PolygonGroups().GetElementIDs())
 		{
-			const FName MaterialName = MeshAttributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupId];
-			UMaterialInstanceDynamic* Material = CachedMaterial(MeshMaterials[MaterialIndex], MaterialName, StaticMesh);
+			// The material references are owned by the mesh and released with it (see ReleaseResources)
+			const FName SlotName = MaterialSlotNames[PolygonGroupId];
+			UMaterialInstanceDynamic* Material = CachedMaterial(GeneratedMesh.Materials[MaterialIndex], SlotName, StaticMesh);
 
-			if (MaterialSlots.Contains(Material))
-			{
-				MeshAttributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupId] = MaterialSlots[Material];
-			}
-			else
-			{
-				const FName SlotName = StaticMesh->AddMaterial(Material);
-				MeshAttributes.GetPolygonGroupMaterialSlotNames()[PolygonGroupId] = SlotName;
-				MaterialSlots.Add(Material, SlotName);
-			}
+			FStaticMaterial& StaticMaterial = StaticMesh->StaticMaterials.Emplace_GetRef(Material, SlotName, SlotName);
+			StaticMaterial.UVChannelData = FMeshUVChannelInfo(1.f);
 
 			++MaterialIndex;
-
-			// cache collision data
-			for (FPolygonID PolygonID : MeshDescription.GetPolygonGroupPolygons(PolygonGroupId))
-			{
-				for (FTriangleID TriangleID : MeshDescription.GetPolygonTriangleIDs(PolygonID))
-				{
-					auto TriangleVertexInstances = MeshDescription.GetTriangleVertexInstances(TriangleID);
-
-					auto VertexID0 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[0]);
-					auto VertexID1 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[1]);
-					auto VertexID2 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[2]);
-
-					FTriIndices TriIndex;
-					TriIndex.v0 = VertexID0.GetValue();
-					TriIndex.v1 = VertexID1.GetValue();
-					TriIndex.v2 = VertexID2.GetValue();
-					Indices.Add(TriIndex);
-				}
-			}
 		}
 
-		TArray<const FMeshDescription*> MeshDescriptionPtrs;
-		MeshDescriptionPtrs.Emplace(&IdAndMesh.Value);
-		StaticMesh->BuildFromMeshDescriptions(MeshDescriptionPtrs);
-		MeshMap.Add(IdAndMesh.Key, MakeTuple(StaticMesh, Vitruvio::FCollisionData{Indices, Vertices}));
+		StaticMeshRegistry.Add(GeneratedMesh.ContentHash, GenerateCollision, StaticMesh);
+		AcquiredMeshes.Add(StaticMesh);
+
+		StaticMeshes.Add(StaticMesh);
+		MeshDescriptions.Add(&MeshDescription);
+		MeshMap.Add(IdAndMesh.Key, MakeTuple(StaticMesh, IdAndMesh.Value));
 	}
 
+	Vitruvio::BuildStaticMeshes(StaticMeshes, MeshDescriptions);
+
 	// convert materials
 	TArray<FInstance> Instances;
 	for (const auto& Instance : GenerateResult.Instances)
 	{
 		UStaticMesh* Mesh = MeshMap[Instance.Key.PrototypeId].Key;
-		Vitruvio::FCollisionData& CollisionData = MeshMap[Instance.Key.PrototypeId].Value;
+		const Vitruvio::FGeneratedMesh& GeneratedMesh = *MeshMap[Instance.Key.PrototypeId].Value;
 		TArray<UMaterialInstanceDynamic*> OverrideMaterials;
 		for (size_t MaterialIndex = 0; MaterialIndex < Instance.Key.MaterialOverrides.Num(); ++MaterialIndex)
 		{
 			const Vitruvio::FMaterialAttributeContainer& MaterialContainer = Instance.Key.MaterialOverrides[MaterialIndex];
 			FName MaterialName = FName(MaterialContainer.Name);
-			OverrideMaterials.Add(CachedMaterial(MaterialContainer, MaterialName, GetTransientPackage()));
+			UMaterialInstanceDynamic* OverrideMaterial = CachedMaterial(MaterialContainer, MaterialName, GetTransientPackage());
+			OverrideMaterials.Add(OverrideMaterial);
+			AcquiredMaterials.Add(OverrideMaterial);
 		}
 
-		Instances.Add({Mesh, CollisionData, OverrideMaterials, Instance.Value});
+		const FSHAHash InstanceKey = Vitruvio::ComputeInstanceKey(GeneratedMesh.ContentHash, Instance.Key.MaterialOverrides);
+		Instances.Add({Mesh, GeneratedMesh.CollisionData, OverrideMaterials, Instance.Value, InstanceKey});
 	}
 
 	if (MeshMap.Contains(UnrealCallbacks::NO_PROTOTYPE_INDEX))
 	{
-		return {MeshMap[UnrealCallbacks::NO_PROTOTYPE_INDEX].Key, MeshMap[UnrealCallbacks::NO_PROTOTYPE_INDEX].Value, Instances};
+		const TTuple<UStaticMesh*, Vitruvio::FGeneratedMeshPtr>& ShapeMesh = MeshMap[UnrealCallbacks::NO_PROTOTYPE_INDEX];
+		return {ShapeMesh.Key, ShapeMesh.Value->CollisionData, Instances, AcquiredMeshes, AcquiredMaterials};
 	}
-	return {nullptr, Vitruvio::FCollisionData{}, Instances};
+	return {nullptr, nullptr, Instances, AcquiredMeshes, AcquiredMaterials};
 }
 
 void UVitruvioComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
@@ -631,13 +996,20 @@ void UVitruvioComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
 	if (GenerateToken)
 	{
 		GenerateToken->Invalidate();
+		GenerateToken.Reset();
 	}
+	bGeneratePending = false;
 
 	if (LoadAttributesInvalidationToken)
 	{
 		LoadAttributesInvalidationToken->Invalidate();
 	}
 
+	AttributeMapBuilderCache.Reset();
+	ResetAttributeSchema();
+	ResetApplyState();
+	ReleaseAppliedResources();
+
 #if WITH_EDITOR
 	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(PropertyChangeDelegate);
 	PropertyChangeDelegate.Reset();
@@ -657,47 +1029,104 @@ void UVitruvioComponent::Generate()
 	// If either the RPK, initial shape or attributes are not ready we can not generate
 	if (!HasValidInputData())
 	{
+		bGeneratePending = false;
 		RemoveGeneratedMeshes();
 		return;
 	}
 
-	// Since we can not abort an ongoing generate call from PRT, we invalidate the result and regenerate after the current generate call has
-	// completed.
-	if (GenerateToken)
+	// A request is dispatched right away if the component is idle. Otherwise requests are coalesced and dispatched by ProcessPendingGenerate,
+	// which is called again on every tick until the request is dispatched.
+	const UVitruvioSettings* Settings = GetDefault<UVitruvioSettings>();
+	const double Now = FPlatformTime::Seconds();
+	if (!GenerateToken && Now - LastGenerateStartTime >= Settings->MinGenerateIntervalMs / 1000.0)
 	{
-		GenerateToken->RequestRegenerate();
-
+		bGeneratePending = false;
+		LastGenerateStartTime = Now;
+		StartGenerate();
 		return;
 	}
 
-	if (InitialShape)
+	if (!bGeneratePending)
 	{
-		FGenerateResult GenerateResult = VitruvioModule::Get().GenerateAsync(InitialShape->GetFaces(), OpaqueParent, MaskedParent, TranslucentParent,
-																			 Rpk, Vitruvio::CreateAttributeMap(Attributes), RandomSeed);
+		bGeneratePending = true;
+		FirstPendingGenerateTime = Now;
+	}
+	LastGenerateRequestTime = Now;
 
-		GenerateToken = GenerateResult.Token;
+	ProcessPendingGenerate();
+}
 
-		// clang-format off
-		GenerateResult.Result.Next([this](const FGenerateResult::ResultType& Result)
+void UVitruvioComponent::ProcessPendingGenerate()
+{
+	if (!bGeneratePending)
+	{
+		return;
+	}
+
+	const UVitruvioSettings* Settings = GetDefault<UVitruvioSettings>();
+	const double Now = FPlatformTime::Seconds();
+
+	// Dispatch on the trailing edge of the debounce window, or after the maximum delay if requests keep coming (eg. during a slider drag)
+	const bool bRequestsSettled = Now - LastGenerateRequestTime >= Settings->GenerateDebounceMs / 1000.0;
+	const bool bMaxDelayElapsed = Settings->MaxGenerateDelayMs > 0 && Now - FirstPendingGenerateTime >= Settings->MaxGenerateDelayMs / 1000.0;
+	if (!bRequestsSettled && !bMaxDelayElapsed)
+	{
+		return;
+	}
+
+	if (GenerateToken)
+	{
+		// Once the requests have settled the outdated generate call is canceled (PRT polls the token through the encoder callbacks) to get
+		// to the final result sooner. While requests keep coming it may finish so that intermediate results are shown.
+		if (bRequestsSettled && !GenerateToken->IsRegenerateRequested())
 		{
-			FScopeLock Lock(&Result.Token->Lock);
+			GenerateToken->RequestRegenerate();
+		}
+		return;
+	}
 
-			if (Result.Token->IsInvalid()) {
-				return;
-			}
+	if (Now - LastGenerateStartTime < Settings->MinGenerateIntervalMs / 1000.0)
+	{
+		return;
+	}
 
-			GenerateToken.Reset();
-			if (Result.Token->IsRegenerateRequested())
-			{
-				Generate();
-			}
-			else
-			{
-				GenerateQueue.Enqueue(Result.Value);
-			}
-		});
-		// clang-format on
+	bGeneratePending = false;
+	LastGenerateStartTime = Now;
+	StartGenerate();
+}
+
+void UVitruvioComponent::StartGenerate()
+{
+	// The input data might have changed since the generate has been requested
+	if (!IsReadyToGenerate() || !InitialShape)
+	{
+		return;
 	}
+
+	if (!AttributeMapBuilderCache)
+	{
+		AttributeMapBuilderCache = MakeShared<Vitruvio::FAttributeMapBuilderCache>();
+	}
+
+	FGenerateResult GenerateResult =
+		VitruvioModule::Get().GenerateAsync(InitialShape->GetFaces(), OpaqueParent, MaskedParent, TranslucentParent, Rpk,
+											AttributeMapBuilderCache->CreateAttributeMap(Attributes), RandomSeed);
+
+	GenerateToken = GenerateResult.Token;
+
+	// clang-format off
+	GenerateResult.Result.Next([this](const FGenerateResult::ResultType& Result)
+	{
+		FScopeLock Lock(&Result.Token->Lock);
+
+		if (Result.Token->IsInvalid()) {
+			return;
+		}
+
+		// Canceled results are enqueued as well, the generate token is only released on the game thread (see ProcessGenerateQueue)
+		GenerateQueue.Enqueue(Result);
+	});
+	// clang-format on
 }
 
 #if WITH_EDITOR
@@ -727,6 +1156,8 @@ void UVitruvioComponent::OnPropertyChanged(UObject* Object, FPropertyChangedEven
 	if (PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(UVitruvioComponent, Rpk))
 	{
 		Attributes.Empty();
+		AttributeMapBuilderCache.Reset();
+		ResetAttributeSchema();
 		bAttributesReady = false;
 		bComponentPropertyChanged = true;
 		bNotifyAttributeChange = true;
@@ -833,6 +1264,38 @@ void UVitruvioComponent::LoadDefaultAttributes(const bool KeepOldAttributeValues
 	});
 }
 
+void UVitruvioComponent::LoadAttributeSchema()
+{
+	check(Rpk);
+
+	ResetAttributeSchema();
+
+	const FAttributeMapResult::FTokenPtr Token = MakeShared<FInvalidationToken>();
+	LoadAttributeSchemaInvalidationToken = Token;
+
+	VitruvioModule::Get().LoadAttributeSchemaAsync(Rpk).Next([this, Token](const TSharedPtr<const Vitruvio::FAttributeSchema>& Schema) {
+		FScopeLock Lock(&Token->Lock);
+
+		if (Token->IsInvalid())
+		{
+			return;
+		}
+
+		AttributeSchemaQueue.Enqueue(Schema);
+	});
+}
+
+void UVitruvioComponent::ResetAttributeSchema()
+{
+	if (LoadAttributeSchemaInvalidationToken)
+	{
+		LoadAttributeSchemaInvalidationToken->Invalidate();
+		LoadAttributeSchemaInvalidationToken.Reset();
+	}
+	AttributeSchemaQueue.Empty();
+	AttributeSchema.Reset();
+}
+
 TArray<TSubclassOf<UInitialShape>> UVitruvioComponent::GetInitialShapesClasses()
 {
 	return {UStaticMeshInitialShape::StaticClass(), USplineInitialShape::StaticClass()};
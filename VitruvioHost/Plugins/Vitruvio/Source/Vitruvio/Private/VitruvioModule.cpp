@@ -15,10 +15,21 @@
 
 #include "VitruvioModule.h"
 
+#include "ApplyScheduler.h"
 #include "AsyncHelpers.h"
+#include "Benchmarks.h"
+#include "GenerateResultCache.h"
+#include "GenerateResultDiskCache.h"
+#include "GenerateThreadPool.h"
+#include "MaterialCache.h"
 #include "PRTTypes.h"
 #include "PRTUtils.h"
+#include "RpkUnpackCache.h"
+#include "RulePackageContext.h"
+#include "StaticMeshRegistry.h"
+#include "TextureCache.h"
 #include "UnrealCallbacks.h"
+#include "VitruvioSettings.h"
 
 #include "Util/AttributeConversion.h"
 #include "Util/MaterialConversion.h"
@@ -27,6 +38,7 @@
 #include "prt/API.h"
 #include "prtx/EncoderInfoBuilder.h"
 
+#include "Containers/Ticker.h"
 #include "Core.h"
 #include "Interfaces/IPluginManager.h"
 #include "MeshDescription.h"
@@ -43,19 +55,23 @@ namespace
 {
 constexpr const wchar_t* ATTRIBUTE_EVAL_ENCODER_ID = L"com.esri.prt.core.AttributeEvalEncoder";
 
+using FRulePackageContextPtr = TSharedPtr<const Vitruvio::FRulePackageContext>;
+
 class FLoadResolveMapTask
 {
 	TLazyObjectPtr<URulePackage> LazyRulePackagePtr;
-	TPromise<ResolveMapSPtr> Promise;
-	TMap<TLazyObjectPtr<URulePackage>, ResolveMapSPtr>& ResolveMapCache;
+	TPromise<FRulePackageContextPtr> Promise;
+	TMap<TLazyObjectPtr<URulePackage>, FRulePackageContextPtr>& RulePackageContextCache;
 	FCriticalSection& LoadResolveMapLock;
-	FString RpkFolder;
+	Vitruvio::FRpkUnpackCache& RpkUnpackCache;
+	prt::Cache* PrtCache;
 
 public:
-	FLoadResolveMapTask(TPromise<ResolveMapSPtr>&& InPromise, const FString RpkFolder, const TLazyObjectPtr<URulePackage> LazyRulePackagePtr,
-						TMap<TLazyObjectPtr<URulePackage>, ResolveMapSPtr>& ResolveMapCache, FCriticalSection& LoadResolveMapLock)
-		: LazyRulePackagePtr(LazyRulePackagePtr), Promise(MoveTemp(InPromise)), ResolveMapCache(ResolveMapCache),
-		  LoadResolveMapLock(LoadResolveMapLock), RpkFolder(RpkFolder)
+	FLoadResolveMapTask(TPromise<FRulePackageContextPtr>&& InPromise, Vitruvio::FRpkUnpackCache& RpkUnpackCache, prt::Cache* PrtCache,
+						const TLazyObjectPtr<URulePackage> LazyRulePackagePtr,
+						TMap<TLazyObjectPtr<URulePackage>, FRulePackageContextPtr>& RulePackageContextCache, FCriticalSection& LoadResolveMapLock)
+		: LazyRulePackagePtr(LazyRulePackagePtr), Promise(MoveTemp(InPromise)), RulePackageContextCache(RulePackageContextCache),
+		  LoadResolveMapLock(LoadResolveMapLock), RpkUnpackCache(RpkUnpackCache), PrtCache(PrtCache)
 	{
 	}
 
@@ -82,38 +98,19 @@ public:
 	{
 		const FString UriPath = LazyRulePackagePtr->GetPathName();
 
-		// Create rpk on disk for PRT
-		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		// The content of the rule package is only loaded, written to disk and unpacked if it has not been unpacked in a previous session
+		URulePackage* RulePackage = LazyRulePackagePtr.Get();
+		const ResolveMapSPtr ResolveMapPtr =
+			RpkUnpackCache.GetResolveMap(FPaths::GetBaseFilename(UriPath, true), RulePackage->GetContentHash(),
+										 [RulePackage](const FString& RpkPath) { return RulePackage->SaveDataToFile(RpkPath); });
 
-		const FString RpkFile = FPaths::GetBaseFilename(UriPath, true) + TEXT(".rpk");
-		const FString RpkPath = FPaths::Combine(RpkFolder, RpkFile);
-		PlatformFile.CreateDirectoryTree(*RpkFolder);
-		IFileHandle* RpkHandle = PlatformFile.OpenWrite(*RpkPath);
-		if (RpkHandle)
-		{
-			// Write file to disk
-			RpkHandle->Write(LazyRulePackagePtr->Data.GetData(), LazyRulePackagePtr->Data.Num());
-			RpkHandle->Flush();
-			delete RpkHandle;
-
-			// Create rpk
-			const std::wstring AbsoluteRpkPath(TCHAR_TO_WCHAR(*FPaths::ConvertRelativePathToFull(RpkPath)));
-			const std::wstring AbsoluteRpkFolder(TCHAR_TO_WCHAR(*FPaths::Combine(FPaths::GetPath(FPaths::ConvertRelativePathToFull(RpkPath)),
-																				 FPaths::GetBaseFilename(UriPath, true) + TEXT("_Unpacked"))));
-			const std::wstring RpkFileUri = prtu::toFileURI(AbsoluteRpkPath);
-
-			prt::Status Status;
-			const ResolveMapSPtr ResolveMapPtr(prt::createResolveMap(RpkFileUri.c_str(), AbsoluteRpkFolder.c_str(), &Status), PRTDestroyer());
-			{
-				FScopeLock Lock(&LoadResolveMapLock);
-				ResolveMapCache.Add(LazyRulePackagePtr, ResolveMapPtr);
-				Promise.SetValue(ResolveMapPtr);
-			}
-		}
-		else
-		{
-			Promise.SetValue(nullptr);
-		}
+		// Rule file, start rule and attributes are the same for all generate and attribute calls of the rule package
+		const FRulePackageContextPtr Context = Vitruvio::FRulePackageContext::Create(ResolveMapPtr, PrtCache);
+
+		// A failed (null) context is cached as well so that an invalid rule package is not written out and unpacked again on every call
+		FScopeLock Lock(&LoadResolveMapLock);
+		RulePackageContextCache.Add(LazyRulePackagePtr, Context);
+		Promise.SetValue(Context);
 	}
 };
 
@@ -147,32 +144,6 @@ void SetInitialShapeGeometry(const InitialShapeBuilderUPtr& InitialShapeBuilder,
 	}
 }
 
-AttributeMapUPtr GetDefaultAttributeValues(const std::wstring& RuleFile, const std::wstring& StartRule, const ResolveMapSPtr& ResolveMapPtr,
-										   const TArray<FInitialShapeFace>& InitialShape, prt::Cache* Cache, const int32 RandomSeed)
-{
-	AttributeMapBuilderUPtr UnrealCallbacksAttributeBuilder(prt::AttributeMapBuilder::create());
-	UnrealCallbacks UnrealCallbacks(UnrealCallbacksAttributeBuilder, nullptr, nullptr, nullptr);
-
-	InitialShapeBuilderUPtr InitialShapeBuilder(prt::InitialShapeBuilder::create());
-
-	SetInitialShapeGeometry(InitialShapeBuilder, InitialShape);
-
-	const AttributeMapUPtr EmptyAttributes(AttributeMapBuilderUPtr(prt::AttributeMapBuilder::create())->createAttributeMap());
-	InitialShapeBuilder->setAttributes(RuleFile.c_str(), StartRule.c_str(), RandomSeed, L"", EmptyAttributes.get(), ResolveMapPtr.get());
-
-	const InitialShapeUPtr Shape(InitialShapeBuilder->createInitialShapeAndReset());
-	const InitialShapeNOPtrVector InitialShapes = {Shape.get()};
-
-	const std::vector<const wchar_t*> EncoderIds = {ATTRIBUTE_EVAL_ENCODER_ID};
-	const AttributeMapUPtr AttributeEncodeOptions = prtu::createValidatedOptions(ATTRIBUTE_EVAL_ENCODER_ID);
-	const AttributeMapNOPtrVector EncoderOptions = {AttributeEncodeOptions.get()};
-
-	prt::generate(InitialShapes.data(), InitialShapes.size(), nullptr, EncoderIds.data(), EncoderIds.size(), EncoderOptions.data(), &UnrealCallbacks,
-				  Cache, nullptr);
-
-	return AttributeMapUPtr(UnrealCallbacksAttributeBuilder->createAttributeMap());
-}
-
 void CleanupTempRpkFolder()
 {
 	FString TempDir(WCHAR_TO_TCHAR(prtu::temp_directory_path().c_str()));
@@ -229,6 +200,19 @@ FString GetPrtDllPath()
 
 } // namespace
 
+struct VitruvioModule::FPendingAttributeRequest
+{
+	TArray<FInitialShapeFace> InitialShape;
+	URulePackage* RulePackage = nullptr;
+	int32 RandomSeed = 0;
+	FAttributeMapResult::FTokenPtr Token;
+	TPromise<FAttributeMapResult::ResultType> Promise;
+};
+
+VitruvioModule::VitruvioModule() : StaticMeshRegistry(MakeUnique<Vitruvio::FStaticMeshRegistry>()) {}
+
+VitruvioModule::~VitruvioModule() = default;
+
 void VitruvioModule::InitializePrt()
 {
 	const FString PrtLibPath = GetPrtDllPath();
@@ -254,12 +238,38 @@ void VitruvioModule::InitializePrt()
 
 	PrtCache.reset(prt::CacheObject::create(prt::CacheObject::CACHE_TYPE_NONREDUNDANT));
 
-	const FString TempDir(WCHAR_TO_TCHAR(prtu::temp_directory_path().c_str()));
-	RpkFolder = FPaths::CreateTempFilename(*TempDir, TEXT("Vitruvio_"), TEXT(""));
+	UnrealEncoderOptions = prtu::createValidatedOptions(UNREAL_GEOMETRY_ENCODER_ID);
+	AttributeEvalEncoderOptions = prtu::createValidatedOptions(ATTRIBUTE_EVAL_ENCODER_ID);
+
+	const UVitruvioSettings* Settings = GetDefault<UVitruvioSettings>();
+	GenerateThreadPool = MakeUnique<Vitruvio::FGenerateThreadPool>(Settings->GetNumGenerateThreads(), TEXT("VitruvioGenerateThreadPool"));
+	if (Settings->GenerateCacheSizeMB > 0)
+	{
+		GenerateResultCache = MakeUnique<Vitruvio::FGenerateResultCache>(static_cast<int64>(Settings->GenerateCacheSizeMB) * 1024 * 1024);
+	}
+	ApplyScheduler = MakeUnique<Vitruvio::FApplyScheduler>(Settings->ApplyBudgetMs);
+
+	const FString RpkCacheDir = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Vitruvio"), TEXT("RpkCache"));
+	RpkUnpackCache = MakeUnique<Vitruvio::FRpkUnpackCache>(RpkCacheDir, static_cast<int64>(Settings->RpkCacheSizeMB) * 1024 * 1024);
+
+	if (Settings->bEnableDiskCache)
+	{
+		const FString DiskCacheDir = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Vitruvio"), TEXT("GenerateCache"));
+		GenerateResultDiskCache = MakeUnique<Vitruvio::FGenerateResultDiskCache>(DiskCacheDir, RpkUnpackCache->GetDirectory(),
+																				  static_cast<int64>(Settings->DiskCacheSizeMB) * 1024 * 1024);
+	}
 }
 
 void VitruvioModule::StartupModule()
 {
+#if !UE_BUILD_SHIPPING
+	Vitruvio::InstallBenchmarkAllocationCounter();
+#endif
+
+	const UVitruvioSettings* Settings = GetDefault<UVitruvioSettings>();
+	TextureCache = MakeUnique<Vitruvio::FTextureCache>(static_cast<int64>(Settings->TextureCacheSizeMB) * 1024 * 1024);
+	MaterialCache = MakeUnique<Vitruvio::FMaterialCache>(Settings->MaxUnusedMaterials, *TextureCache);
+
 	// During cooking we do not start Vitruvio
 	if (IsRunningCommandlet())
 	{
@@ -278,6 +288,14 @@ void VitruvioModule::ShutdownModule()
 
 	Initialized = false;
 
+	// Pending attribute requests are completed without being evaluated since the module is not initialized anymore
+	{
+		FScopeLock Lock(&PendingAttributeRequestsLock);
+		FTicker::GetCoreTicker().RemoveTicker(AttributeBatchTickerHandle);
+		AttributeBatchTickerHandle.Reset();
+	}
+	FlushAttributeRequests();
+
 	UE_LOG(LogUnrealPrt, Display,
 		   TEXT("Shutting down Vitruvio. Waiting for ongoing generate calls (%d), RPK loading tasks (%d) and attribute loading tasks (%d)"),
 		   GenerateCallsCounter.GetValue(), RpkLoadingTasksCounter.GetValue(), LoadAttributesCounter.GetValue())
@@ -289,6 +307,17 @@ void VitruvioModule::ShutdownModule()
 
 	UE_LOG(LogUnrealPrt, Display, TEXT("PRT calls finished. Shutting down."))
 
+	GenerateThreadPool.Reset();
+	GenerateResultCache.Reset();
+	GenerateResultDiskCache.Reset();
+	ApplyScheduler.Reset();
+	RpkUnpackCache.Reset();
+
+	// PRT objects have to be destroyed before the library
+	RulePackageContextCache.Empty();
+	UnrealEncoderOptions.reset();
+	AttributeEvalEncoderOptions.reset();
+
 	if (PrtDllHandle)
 	{
 		FPlatformProcess::FreeDllHandle(PrtDllHandle);
@@ -308,7 +337,7 @@ void VitruvioModule::ShutdownModule()
 
 FGenerateResult VitruvioModule::GenerateAsync(const TArray<FInitialShapeFace>& InitialShape, UMaterial* OpaqueParent, UMaterial* MaskedParent,
 											  UMaterial* TranslucentParent, URulePackage* RulePackage, AttributeMapUPtr Attributes,
-											  const int32 RandomSeed) const
+											  const int32 RandomSeed, Vitruvio::EGeneratePriority Priority) const
 {
 	check(RulePackage);
 
@@ -326,11 +355,16 @@ FGenerateResult VitruvioModule::GenerateAsync(const TArray<FInitialShapeFace>& I
 		};
 	}
 
-	FGenerateResult::FFutureType ResultFuture = Async(EAsyncExecution::Thread, [=, AttributeMap = std::move(Attributes)]() mutable {
-		FGenerateResultDescription Result =
-			Generate(InitialShape, OpaqueParent, MaskedParent, TranslucentParent, RulePackage, std::move(AttributeMap), RandomSeed);
-		return FGenerateResult::ResultType{Token, MoveTemp(Result)};
-	});
+	FGenerateResult::FFutureType ResultFuture = GenerateThreadPool->Execute<FGenerateResult::ResultType>(
+		[=, AttributeMap = std::move(Attributes)]() mutable {
+			TArray<FGenerateRequest> Requests;
+			Requests.Add({InitialShape, RulePackage, std::move(AttributeMap), RandomSeed});
+
+			TArray<FGenerateResultDescription> Results = GenerateBatchInternal(MoveTemp(Requests), Token.Get());
+			PrefetchTextures(Results);
+			return FGenerateResult::ResultType{Token, MoveTemp(Results[0])};
+		},
+		Priority);
 
 	return FGenerateResult{MoveTemp(ResultFuture), Token};
 }
@@ -347,32 +381,189 @@ FGenerateResultDescription VitruvioModule::Generate(const TArray<FInitialShapeFa
 		return {};
 	}
 
+	TArray<FGenerateRequest> Requests;
+	Requests.Add({InitialShape, RulePackage, std::move(Attributes), RandomSeed});
+
+	TArray<FGenerateResultDescription> Results = GenerateBatchInternal(MoveTemp(Requests), nullptr);
+	return MoveTemp(Results[0]);
+}
+
+FBatchGenerateResult VitruvioModule::GenerateBatchAsync(TArray<FGenerateRequest> Requests, Vitruvio::EGeneratePriority Priority) const
+{
+	const FBatchGenerateResult::FTokenPtr Token = MakeShared<FGenerateToken>();
+
+	if (!Initialized)
+	{
+		UE_LOG(LogUnrealPrt, Warning, TEXT("PRT not initialized"))
+
+		TArray<FGenerateResultDescription> EmptyResults;
+		EmptyResults.SetNum(Requests.Num());
+
+		TPromise<FBatchGenerateResult::ResultType> Result;
+		Result.SetValue({Token, MoveTemp(EmptyResults)});
+		return {
+			Result.GetFuture(),
+			Token,
+		};
+	}
+
+	FBatchGenerateResult::FFutureType ResultFuture = GenerateThreadPool->Execute<FBatchGenerateResult::ResultType>(
+		[this, Token, Requests = MoveTemp(Requests)]() mutable {
+			TArray<FGenerateResultDescription> Results = GenerateBatchInternal(MoveTemp(Requests), Token.Get());
+			PrefetchTextures(Results);
+			return FBatchGenerateResult::ResultType{Token, MoveTemp(Results)};
+		},
+		Priority);
+
+	return FBatchGenerateResult{MoveTemp(ResultFuture), Token};
+}
+
+TArray<FGenerateResultDescription> VitruvioModule::GenerateBatch(TArray<FGenerateRequest> Requests) const
+{
+	return GenerateBatchInternal(MoveTemp(Requests), nullptr);
+}
+
+void VitruvioModule::PrefetchTextures(const TArray<FGenerateResultDescription>& Results) const
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_VitruvioModule_PrefetchTextures);
+
+	// Maps the texture paths to their material property (which determines the texture settings)
+	TMap<FString, FString> TexturePaths;
+	auto AddTextures = [&TexturePaths](const TArray<Vitruvio::FMaterialAttributeContainer>& Materials) {
+		for (const Vitruvio::FMaterialAttributeContainer& Material : Materials)
+		{
+			for (const auto& TextureProperty : Material.TextureProperties)
+			{
+				TexturePaths.Add(TextureProperty.Value, TextureProperty.Key);
+			}
+		}
+	};
+
+	for (const FGenerateResultDescription& Result : Results)
+	{
+		for (const auto& IdAndMesh : Result.Meshes)
+		{
+			AddTextures(IdAndMesh.Value->Materials);
+		}
+		for (const auto& Instance : Result.Instances)
+		{
+			AddTextures(Instance.Key.MaterialOverrides);
+		}
+	}
+
+	// Only start loading the textures, the reference is released right away. Applying the result acquires its own references and waits
+	// for the loads (see UVitruvioComponent::ApplyNextStep).
+	for (const auto& PathAndKey : TexturePaths)
+	{
+		TextureCache->LoadAsync(PathAndKey.Key, PathAndKey.Value);
+		TextureCache->Release(PathAndKey.Key);
+	}
+}
+
+TArray<FGenerateResultDescription> VitruvioModule::GenerateBatchInternal(TArray<FGenerateRequest> Requests, const FGenerateToken* CancelToken) const
+{
+	TArray<FGenerateResultDescription> Results;
+	Results.SetNum(Requests.Num());
+
+	if (!Initialized)
+	{
+		UE_LOG(LogUnrealPrt, Warning, TEXT("PRT not initialized"))
+		return Results;
+	}
+
+	if (Requests.Num() == 0)
+	{
+		return Results;
+	}
+
+	// Superseded requests which are still waiting in the generate queue do not need to be generated at all
+	const auto IsCanceled = [CancelToken]() { return CancelToken && CancelToken->IsCanceled(); };
+	if (IsCanceled())
+	{
+		UE_LOG(LogUnrealPrt, Verbose, TEXT("Skipped canceled generate call"))
+		return Results;
+	}
+
 	GenerateCallsCounter.Increment();
 
+	// Requests which have already been generated with identical inputs are served from the cache
+	TArray<FSHAHash> CacheKeys;
+	if (GenerateResultCache || GenerateResultDiskCache)
+	{
+		CacheKeys.SetNum(Requests.Num());
+		for (int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+		{
+			CacheKeys[RequestIndex] = Vitruvio::FGenerateResultCache::ComputeKey(Requests[RequestIndex]);
+		}
+	}
+
+	// Avoids looking up the context of the same rule package for every request in the batch
+	TMap<URulePackage*, FRulePackageContextPtr> RulePackageContexts;
+
 	const InitialShapeBuilderUPtr InitialShapeBuilder(prt::InitialShapeBuilder::create());
-	SetInitialShapeGeometry(InitialShapeBuilder, InitialShape);
 
-	const ResolveMapSPtr ResolveMap = LoadResolveMapAsync(RulePackage).Get();
+	std::vector<InitialShapeUPtr> InitialShapes;
+	InitialShapeNOPtrVector Shapes;
+	TArray<int32> ShapeToRequestIndex;
 
-	const std::wstring RuleFile = prtu::getRuleFileEntry(ResolveMap);
-	const wchar_t* RuleFileUri = ResolveMap->getString(RuleFile.c_str());
+	for (int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+	{
+		const FGenerateRequest& Request = Requests[RequestIndex];
+		check(Request.RulePackage);
 
-	const RuleFileInfoUPtr StartRuleInfo(prt::createRuleFileInfo(RuleFileUri));
-	const std::wstring StartRule = prtu::detectStartRule(StartRuleInfo);
+		if (GenerateResultCache && GenerateResultCache->Find(CacheKeys[RequestIndex], Results[RequestIndex]))
+		{
+			continue;
+		}
 
-	InitialShapeBuilder->setAttributes(RuleFile.c_str(), StartRule.c_str(), RandomSeed, L"", Attributes.get(), ResolveMap.get());
+		// Results from previous sessions skip PRT entirely, eg. when a level is opened
+		if (GenerateResultDiskCache && GenerateResultDiskCache->Load(CacheKeys[RequestIndex], Results[RequestIndex]))
+		{
+			// Textures referenced by the cached materials are only available once the rule package has been unpacked in this session
+			LoadRulePackageContextAsync(Request.RulePackage).Wait();
 
-	AttributeMapBuilderUPtr AttributeMapBuilder(prt::AttributeMapBuilder::create());
-	const TSharedPtr<UnrealCallbacks> OutputHandler(new UnrealCallbacks(AttributeMapBuilder, OpaqueParent, MaskedParent, TranslucentParent));
+			if (GenerateResultCache)
+			{
+				GenerateResultCache->Add(CacheKeys[RequestIndex], Results[RequestIndex]);
+			}
+			continue;
+		}
+
+		FRulePackageContextPtr* Context = RulePackageContexts.Find(Request.RulePackage);
+		if (!Context)
+		{
+			Context = &RulePackageContexts.Add(Request.RulePackage, LoadRulePackageContextAsync(Request.RulePackage).Get());
+		}
 
-	const InitialShapeUPtr Shape(InitialShapeBuilder->createInitialShapeAndReset());
+		if (!*Context)
+		{
+			UE_LOG(LogUnrealPrt, Error, TEXT("Could not load rule package %s"), *Request.RulePackage->GetName())
+			continue;
+		}
+
+		SetInitialShapeGeometry(InitialShapeBuilder, Request.InitialShape);
+		const std::wstring ShapeName = UnrealCallbacks::GetInitialShapeName(Shapes.size());
+		InitialShapeBuilder->setAttributes((*Context)->RuleFile.c_str(), (*Context)->StartRule.c_str(), Request.RandomSeed, ShapeName.c_str(),
+										   Request.Attributes.get(), (*Context)->ResolveMap.get());
+
+		InitialShapes.emplace_back(InitialShapeBuilder->createInitialShapeAndReset());
+		Shapes.push_back(InitialShapes.back().get());
+		ShapeToRequestIndex.Add(RequestIndex);
+	}
+
+	if (Shapes.empty())
+	{
+		GenerateCallsCounter.Decrement();
+		return Results;
+	}
+
+	AttributeMapBuilderUPtr AttributeMapBuilder(prt::AttributeMapBuilder::create());
+	const TSharedPtr<UnrealCallbacks> OutputHandler(
+		new UnrealCallbacks(AttributeMapBuilder, nullptr, nullptr, nullptr, Shapes.size(), IsCanceled));
 
 	const std::vector<const wchar_t*> EncoderIds = {UNREAL_GEOMETRY_ENCODER_ID};
-	const AttributeMapUPtr UnrealEncoderOptions(prtu::createValidatedOptions(UNREAL_GEOMETRY_ENCODER_ID));
 	const AttributeMapNOPtrVector EncoderOptions = {UnrealEncoderOptions.get()};
 
-	InitialShapeNOPtrVector Shapes = {Shape.get()};
-
 	const prt::Status GenerateStatus = prt::generate(Shapes.data(), Shapes.size(), nullptr, EncoderIds.data(), EncoderIds.size(),
 													 EncoderOptions.data(), OutputHandler.Get(), PrtCache.get(), nullptr);
 
@@ -381,9 +572,36 @@ FGenerateResultDescription VitruvioModule::Generate(const TArray<FInitialShapeFa
 		UE_LOG(LogUnrealPrt, Error, TEXT("PRT generate failed: %hs"), prt::getStatusDescription(GenerateStatus))
 	}
 
+	// The output of a canceled generate call is incomplete and will be discarded by the caller anyway
+	if (IsCanceled())
+	{
+		UE_LOG(LogUnrealPrt, Verbose, TEXT("Canceled ongoing generate call"))
+		GenerateCallsCounter.Decrement();
+		return Results;
+	}
+
+	// Demultiplex the generated output back to the requests
+	for (int32 ShapeIndex = 0; ShapeIndex < ShapeToRequestIndex.Num(); ++ShapeIndex)
+	{
+		const int32 RequestIndex = ShapeToRequestIndex[ShapeIndex];
+		Results[RequestIndex] = {OutputHandler->GetInstances(ShapeIndex), OutputHandler->GetMeshes(ShapeIndex)};
+
+		if (GenerateStatus == prt::STATUS_OK)
+		{
+			if (GenerateResultCache)
+			{
+				GenerateResultCache->Add(CacheKeys[RequestIndex], Results[RequestIndex]);
+			}
+			if (GenerateResultDiskCache)
+			{
+				GenerateResultDiskCache->SaveAsync(CacheKeys[RequestIndex], Results[RequestIndex]);
+			}
+		}
+	}
+
 	GenerateCallsCounter.Decrement();
 
-	return {OutputHandler->GetInstances(), OutputHandler->GetMeshes(), OutputHandler->GetMaterials()};
+	return Results;
 }
 
 FAttributeMapResult VitruvioModule::LoadDefaultRuleAttributesAsync(const TArray<FInitialShapeFace>& InitialShape, URulePackage* RulePackage,
@@ -403,47 +621,233 @@ FAttributeMapResult VitruvioModule::LoadDefaultRuleAttributesAsync(const TArray<
 
 	LoadAttributesCounter.Increment();
 
-	FAttributeMapResult::FFutureType AttributeMapPtrFuture = Async(EAsyncExecution::Thread, [=]() {
-		const ResolveMapSPtr ResolveMap = LoadResolveMapAsync(RulePackage).Get();
+	const TSharedPtr<FPendingAttributeRequest> Request = MakeShared<FPendingAttributeRequest>();
+	Request->InitialShape = InitialShape;
+	Request->RulePackage = RulePackage;
+	Request->RandomSeed = RandomSeed;
+	Request->Token = InvalidationToken;
+	FAttributeMapResult::FFutureType AttributeMapPtrFuture = Request->Promise.GetFuture();
+
+	// Components which are created together (eg. when a level is loaded) request their attributes within a few frames. Gathering the
+	// requests over a short window evaluates them in a single generate call instead of one generate call per component.
+	const float WindowSeconds = GetDefault<UVitruvioSettings>()->AttributeBatchWindowMs / 1000.0f;
+	const bool bFlushNow = WindowSeconds <= 0 || !IsInGameThread();
+	{
+		FScopeLock Lock(&PendingAttributeRequestsLock);
+		PendingAttributeRequests.Add(Request);
+
+		if (!bFlushNow && !AttributeBatchTickerHandle.IsValid())
+		{
+			const auto OnBatchWindowElapsed = [this](float) {
+				{
+					FScopeLock TickerLock(&PendingAttributeRequestsLock);
+					AttributeBatchTickerHandle.Reset();
+				}
+				FlushAttributeRequests();
+				return false;
+			};
+			AttributeBatchTickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda(OnBatchWindowElapsed), WindowSeconds);
+		}
+	}
+
+	if (bFlushNow)
+	{
+		FlushAttributeRequests();
+	}
+
+	return {MoveTemp(AttributeMapPtrFuture), InvalidationToken};
+}
+
+void VitruvioModule::FlushAttributeRequests() const
+{
+	TArray<TSharedPtr<FPendingAttributeRequest>> Requests;
+	{
+		FScopeLock Lock(&PendingAttributeRequestsLock);
+		Requests = MoveTemp(PendingAttributeRequests);
+	}
 
-		const std::wstring RuleFile = prtu::getRuleFileEntry(ResolveMap);
-		const wchar_t* RuleFileUri = ResolveMap->getString(RuleFile.c_str());
+	if (Requests.Num() == 0)
+	{
+		return;
+	}
+
+	// Attributes are required before the first generate call of a component so we load them with a higher priority
+	GenerateThreadPool->Execute<bool>(
+		[this, Requests = MoveTemp(Requests)]() {
+			EvaluateDefaultAttributes(Requests);
+			return true;
+		},
+		Vitruvio::EGeneratePriority::High);
+}
+
+void VitruvioModule::EvaluateDefaultAttributes(const TArray<TSharedPtr<FPendingAttributeRequest>>& Requests) const
+{
+	const InitialShapeBuilderUPtr InitialShapeBuilder(prt::InitialShapeBuilder::create());
+	const AttributeMapUPtr EmptyAttributes(AttributeMapBuilderUPtr(prt::AttributeMapBuilder::create())->createAttributeMap());
 
-		const RuleFileInfoUPtr StartRuleInfo(prt::createRuleFileInfo(RuleFileUri));
-		const std::wstring StartRule = prtu::detectStartRule(StartRuleInfo);
+	// Avoids looking up the context of the same rule package for every request in the batch
+	TMap<URulePackage*, FRulePackageContextPtr> RulePackageContexts;
+	TArray<FRulePackageContextPtr> RequestContexts;
+	RequestContexts.SetNum(Requests.Num());
 
-		prt::Status InfoStatus;
-		RuleFileInfoUPtr RuleInfo(prt::createRuleFileInfo(RuleFileUri, PrtCache.get(), &InfoStatus));
-		if (!RuleInfo || InfoStatus != prt::STATUS_OK)
+	std::vector<InitialShapeUPtr> InitialShapes;
+	InitialShapeNOPtrVector Shapes;
+	TArray<int32> ShapeToRequestIndex;
+
+	for (int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+	{
+		const FPendingAttributeRequest& Request = *Requests[RequestIndex];
+
+		// Components which have been destroyed in the meantime do not need their attributes anymore
+		if (!Initialized || Request.Token->IsInvalid())
 		{
-			UE_LOG(LogUnrealPrt, Error, TEXT("could not get rule file info from rule file %s"), RuleFileUri)
-			return FAttributeMapResult::ResultType{
-				InvalidationToken,
-				nullptr,
-			};
+			continue;
 		}
 
-		AttributeMapUPtr DefaultAttributeMap(
-			GetDefaultAttributeValues(RuleFile.c_str(), StartRule.c_str(), ResolveMap, InitialShape, PrtCache.get(), RandomSeed));
+		FRulePackageContextPtr* Context = RulePackageContexts.Find(Request.RulePackage);
+		if (!Context)
+		{
+			Context = &RulePackageContexts.Add(Request.RulePackage, LoadRulePackageContextAsync(Request.RulePackage).Get());
+		}
 
-		LoadAttributesCounter.Decrement();
+		if (!*Context)
+		{
+			UE_LOG(LogUnrealPrt, Error, TEXT("Could not load rule package %s"), *Request.RulePackage->GetName())
+			continue;
+		}
+
+		SetInitialShapeGeometry(InitialShapeBuilder, Request.InitialShape);
+		InitialShapeBuilder->setAttributes((*Context)->RuleFile.c_str(), (*Context)->StartRule.c_str(), Request.RandomSeed, L"",
+										   EmptyAttributes.get(), (*Context)->ResolveMap.get());
+
+		InitialShapes.emplace_back(InitialShapeBuilder->createInitialShapeAndReset());
+		Shapes.push_back(InitialShapes.back().get());
+		ShapeToRequestIndex.Add(RequestIndex);
+		RequestContexts[RequestIndex] = *Context;
+	}
+
+	TArray<FAttributeMapPtr> Results;
+	Results.SetNum(Requests.Num());
+
+	if (!Shapes.empty())
+	{
+		// The evaluated attributes are routed back to the requests by initial shape index
+		AttributeMapBuilderVector AttributeMapBuilders;
+		for (size_t ShapeIndex = 0; ShapeIndex < Shapes.size(); ++ShapeIndex)
+		{
+			AttributeMapBuilders.emplace_back(prt::AttributeMapBuilder::create());
+		}
+		UnrealCallbacks Callbacks(AttributeMapBuilders);
+
+		const std::vector<const wchar_t*> EncoderIds = {ATTRIBUTE_EVAL_ENCODER_ID};
+		const AttributeMapNOPtrVector EncoderOptions = {AttributeEvalEncoderOptions.get()};
 
-		if (!Initialized)
+		const prt::Status GenerateStatus = prt::generate(Shapes.data(), Shapes.size(), nullptr, EncoderIds.data(), EncoderIds.size(),
+														 EncoderOptions.data(), &Callbacks, PrtCache.get(), nullptr);
+		if (GenerateStatus != prt::STATUS_OK)
 		{
-			return FAttributeMapResult::ResultType{InvalidationToken, nullptr};
+			UE_LOG(LogUnrealPrt, Error, TEXT("PRT attribute evaluation failed: %hs"), prt::getStatusDescription(GenerateStatus))
 		}
 
-		const TSharedPtr<FAttributeMap> AttributeMap = MakeShared<FAttributeMap>(std::move(DefaultAttributeMap), std::move(RuleInfo));
-		return FAttributeMapResult::ResultType{InvalidationToken, AttributeMap};
-	});
+		for (int32 ShapeIndex = 0; ShapeIndex < ShapeToRequestIndex.Num(); ++ShapeIndex)
+		{
+			const int32 RequestIndex = ShapeToRequestIndex[ShapeIndex];
+			AttributeMapUPtr DefaultAttributeMap(AttributeMapBuilders[ShapeIndex]->createAttributeMap());
+			Results[RequestIndex] = MakeShared<FAttributeMap>(std::move(DefaultAttributeMap), RequestContexts[RequestIndex]->AttributeSchema);
+		}
+	}
 
-	return {MoveTemp(AttributeMapPtrFuture), InvalidationToken};
+	for (int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+	{
+		FPendingAttributeRequest& Request = *Requests[RequestIndex];
+		Request.Promise.SetValue(FAttributeMapResult::ResultType{Request.Token, Initialized ? Results[RequestIndex] : nullptr});
+		LoadAttributesCounter.Decrement();
+	}
+}
+
+TFuture<TSharedPtr<const Vitruvio::FAttributeSchema>> VitruvioModule::LoadAttributeSchemaAsync(URulePackage* RulePackage) const
+{
+	check(RulePackage);
+
+	return LoadRulePackageContextAsync(RulePackage).Next(
+		[](const FRulePackageContextPtr& Context) { return Context ? Context->AttributeSchema : TSharedPtr<const Vitruvio::FAttributeSchema>(); });
+}
+
+Vitruvio::FGenerateQueueStats VitruvioModule::GetGenerateQueueStats() const
+{
+	if (!GenerateThreadPool)
+	{
+		return {};
+	}
+	return GenerateThreadPool->GetStats();
+}
+
+Vitruvio::FGenerateCacheStats VitruvioModule::GetGenerateCacheStats() const
+{
+	if (!GenerateResultCache)
+	{
+		return {};
+	}
+	return GenerateResultCache->GetStats();
+}
+
+Vitruvio::FMaterialCacheStats VitruvioModule::GetMaterialCacheStats() const
+{
+	return MaterialCache->GetStats();
+}
+
+Vitruvio::FTextureCacheStats VitruvioModule::GetTextureCacheStats() const
+{
+	return TextureCache->GetStats();
+}
+
+void VitruvioModule::ClearGenerateCache() const
+{
+	if (GenerateResultCache)
+	{
+		GenerateResultCache->Empty();
+	}
+	if (GenerateResultDiskCache)
+	{
+		GenerateResultDiskCache->Empty();
+	}
+}
+
+void VitruvioModule::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	if (MaterialCache)
+	{
+		MaterialCache->AddReferencedObjects(Collector);
+	}
+	if (TextureCache)
+	{
+		TextureCache->AddReferencedObjects(Collector);
+	}
+	StaticMeshRegistry->AddReferencedObjects(Collector);
+
+	// Attribute templates and their annotations are shared by all components using the rule package
+	FScopeLock Lock(&LoadResolveMapLock);
+	for (const auto& Entry : RulePackageContextCache)
+	{
+		if (Entry.Value)
+		{
+			Entry.Value->AttributeSchema->AddReferencedObjects(Collector);
+		}
+	}
+}
+
+void VitruvioModule::ScheduleApply(UVitruvioComponent* Component) const
+{
+	if (ApplyScheduler)
+	{
+		ApplyScheduler->Schedule(Component);
+	}
 }
 
-TFuture<ResolveMapSPtr> VitruvioModule::LoadResolveMapAsync(URulePackage* const RulePackage) const
+TFuture<FRulePackageContextPtr> VitruvioModule::LoadRulePackageContextAsync(URulePackage* const RulePackage) const
 {
-	TPromise<ResolveMapSPtr> Promise;
-	TFuture<ResolveMapSPtr> Future = Promise.GetFuture();
+	TPromise<FRulePackageContextPtr> Promise;
+	TFuture<FRulePackageContextPtr> Future = Promise.GetFuture();
 
 	if (!Initialized)
 	{
@@ -456,10 +860,10 @@ TFuture<ResolveMapSPtr> VitruvioModule::LoadResolveMapAsync(URulePackage* const
 	// Check if has already been cached
 	{
 		FScopeLock Lock(&LoadResolveMapLock);
-		const auto CachedResolveMap = ResolveMapCache.Find(LazyRulePackagePtr);
-		if (CachedResolveMap)
+		const auto CachedContext = RulePackageContextCache.Find(LazyRulePackagePtr);
+		if (CachedContext)
 		{
-			Promise.SetValue(*CachedResolveMap);
+			Promise.SetValue(*CachedContext);
 			return Future;
 		}
 	}
@@ -475,11 +879,11 @@ TFuture<ResolveMapSPtr> VitruvioModule::LoadResolveMapAsync(URulePackage* const
 		// Add task which only fetches the result from the cache once the actual loading has finished
 		FGraphEventArray Prerequisites;
 		Prerequisites.Add(*ScheduledTaskEvent);
-		TGraphTask<TAsyncGraphTask<ResolveMapSPtr>>::CreateTask(&Prerequisites)
+		TGraphTask<TAsyncGraphTask<FRulePackageContextPtr>>::CreateTask(&Prerequisites)
 			.ConstructAndDispatchWhenReady(
 				[this, LazyRulePackagePtr]() {
 					FScopeLock Lock(&LoadResolveMapLock);
-					return ResolveMapCache[LazyRulePackagePtr];
+					return RulePackageContextCache.FindRef(LazyRulePackagePtr);
 				},
 				MoveTemp(Promise), ENamedThreads::AnyThread);
 	}
@@ -491,8 +895,8 @@ TFuture<ResolveMapSPtr> VitruvioModule::LoadResolveMapAsync(URulePackage* const
 		{
 			FScopeLock Lock(&LoadResolveMapLock);
 			// Task which does the actual resolve map loading which might take a long time
-			LoadTask = TGraphTask<FLoadResolveMapTask>::CreateTask().ConstructAndDispatchWhenReady(MoveTemp(Promise), RpkFolder, LazyRulePackagePtr,
-																								   ResolveMapCache, LoadResolveMapLock);
+			LoadTask = TGraphTask<FLoadResolveMapTask>::CreateTask().ConstructAndDispatchWhenReady(
+				MoveTemp(Promise), *RpkUnpackCache, PrtCache.get(), LazyRulePackagePtr, RulePackageContextCache, LoadResolveMapLock);
 			ResolveMapEventGraphRefCache.Add(LazyRulePackagePtr, LoadTask);
 		}
 
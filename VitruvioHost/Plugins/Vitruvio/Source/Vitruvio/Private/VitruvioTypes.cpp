@@ -17,6 +17,9 @@
 
 #include "Core/Public/Containers/UnrealString.h"
 #include "Core/Public/Templates/TypeHash.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/Archive.h"
+#include "StaticMeshAttributes.h"
 
 namespace
 {
@@ -48,6 +51,61 @@ const TMap<FString, EMaterialPropertyType> KeyToTypeMap = {
 };
 // clang-format on
 
+template <typename ValueType>
+void SerializeSorted(FArchive& Ar, const TMap<FString, ValueType>& Map)
+{
+	TArray<FString> Keys;
+	Map.GetKeys(Keys);
+	Keys.Sort();
+	for (FString& Key : Keys)
+	{
+		ValueType Value = Map[Key];
+		Ar << Key << Value;
+	}
+}
+
+// Serializes the properties which are relevant for material equality in a deterministic order
+void SerializeMaterialContent(FArchive& Ar, const Vitruvio::FMaterialAttributeContainer& Material)
+{
+	SerializeSorted(Ar, Material.TextureProperties);
+	SerializeSorted(Ar, Material.ColorProperties);
+	SerializeSorted(Ar, Material.ScalarProperties);
+	SerializeSorted(Ar, Material.StringProperties);
+	FString BlendMode = Material.BlendMode;
+	Ar << BlendMode;
+}
+
+/** Saving archive which hashes the serialized data directly instead of writing it to a buffer first. */
+class FHashWriter final : public FArchive
+{
+public:
+	FHashWriter()
+	{
+		SetIsSaving(true);
+	}
+
+	void Serialize(void* Data, int64 Num) override
+	{
+		HashState.Update(static_cast<const uint8*>(Data), Num);
+	}
+
+	FString GetArchiveName() const override
+	{
+		return TEXT("FHashWriter");
+	}
+
+	FSHAHash GetHash()
+	{
+		FSHAHash Hash;
+		HashState.Final();
+		HashState.GetHash(Hash.Hash);
+		return Hash;
+	}
+
+private:
+	FSHA1 HashState;
+};
+
 FString FirstValidTextureUri(const prt::AttributeMap* MaterialAttributes, wchar_t const* Key)
 {
 	size_t ValuesCount = 0;
@@ -167,4 +225,65 @@ uint32 GetTypeHash(const FInstanceCacheKey& Object)
 	return HashCombine(Object.PrototypeId, GetArrayHash(Object.MaterialOverrides));
 }
 
+FCollisionData CreateCollisionData(const FMeshDescription& MeshDescription)
+{
+	FCollisionData CollisionData;
+
+	const TVertexAttributesConstRef<FVector> VertexPositions =
+		MeshDescription.VertexAttributes().GetAttributesRef<FVector>(MeshAttribute::Vertex::Position);
+	CollisionData.Vertices.Reserve(MeshDescription.Vertices().Num());
+	for (const FVertexID VertexID : MeshDescription.Vertices().GetElementIDs())
+	{
+		CollisionData.Vertices.Add(VertexPositions[VertexID]);
+	}
+
+	CollisionData.Indices.Reserve(MeshDescription.Triangles().Num());
+	for (const FTriangleID TriangleID : MeshDescription.Triangles().GetElementIDs())
+	{
+		const TArrayView<const FVertexInstanceID> TriangleVertexInstances = MeshDescription.GetTriangleVertexInstances(TriangleID);
+
+		FTriIndices TriIndex;
+		TriIndex.v0 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[0]).GetValue();
+		TriIndex.v1 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[1]).GetValue();
+		TriIndex.v2 = MeshDescription.GetVertexInstanceVertex(TriangleVertexInstances[2]).GetValue();
+		CollisionData.Indices.Add(TriIndex);
+	}
+
+	return CollisionData;
+}
+
+FSHAHash ComputeMeshContentHash(const FMeshDescription& MeshDescription, const TArray<FMaterialAttributeContainer>& Materials)
+{
+	FHashWriter Writer;
+
+	// Serialize is not const but only reads from the mesh description when saving
+	const_cast<FMeshDescription&>(MeshDescription).Serialize(Writer);
+
+	int32 NumMaterials = Materials.Num();
+	Writer << NumMaterials;
+	for (const FMaterialAttributeContainer& Material : Materials)
+	{
+		SerializeMaterialContent(Writer, Material);
+	}
+
+	return Writer.GetHash();
+}
+
+FSHAHash ComputeInstanceKey(const FSHAHash& MeshContentHash, const TArray<FMaterialAttributeContainer>& MaterialOverrides)
+{
+	FHashWriter Writer;
+
+	FSHAHash Hash = MeshContentHash;
+	Writer << Hash;
+
+	int32 NumMaterialOverrides = MaterialOverrides.Num();
+	Writer << NumMaterialOverrides;
+	for (const FMaterialAttributeContainer& Material : MaterialOverrides)
+	{
+		SerializeMaterialContent(Writer, Material);
+	}
+
+	return Writer.GetHash();
+}
+
 } // namespace Vitruvio
@@ -15,6 +15,7 @@
 
 #pragma once
 
+#include "AttributeSchema.h"
 #include "RuleAttributes.h"
 
 #include "CoreUObject.h"
@@ -25,13 +26,21 @@ class VITRUVIO_API FAttributeMap
 public:
 	FAttributeMap() {}
 
-	FAttributeMap(AttributeMapUPtr AttributeMap, RuleFileInfoUPtr RuleInfo) : AttributeMap(std::move(AttributeMap)), RuleInfo(std::move(RuleInfo)) {}
+	FAttributeMap(AttributeMapUPtr AttributeMap, TSharedPtr<const Vitruvio::FAttributeSchema> Schema)
+		: AttributeMap(std::move(AttributeMap)), Schema(MoveTemp(Schema))
+	{
+	}
 
 	TMap<FString, URuleAttribute*> ConvertToUnrealAttributeMap(UObject* const Outer);
 
+	const TSharedPtr<const Vitruvio::FAttributeSchema>& GetSchema() const
+	{
+		return Schema;
+	}
+
 private:
 	const AttributeMapUPtr AttributeMap;
-	const RuleFileInfoUPtr RuleInfo;
+	const TSharedPtr<const Vitruvio::FAttributeSchema> Schema;
 };
 
 using FAttributeMapPtr = TSharedPtr<FAttributeMap>;
@@ -0,0 +1,78 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "PRTTypes.h"
+#include "RuleAttributes.h"
+
+#include "CoreUObject.h"
+
+#include <string>
+
+namespace Vitruvio
+{
+/** Name, type and rule file entry of a single rule attribute. */
+struct FRuleAttributeInfo
+{
+	FString Name;
+	FString DisplayName;
+	// The name as passed to PRT
+	std::wstring Key;
+	TSubclassOf<URuleAttribute> Class;
+	// Owned by the rule file info of the schema
+	const prt::RuleFileInfo::Entry* Entry = nullptr;
+};
+
+/**
+ * The attributes (names, types, annotations, groups and order) of a rule package. It is created once per rule package and shared by all
+ * components using the rule package, which only create the attribute objects holding their values. Annotations are parsed only once, the
+ * first time the schema is used on the game thread, and the resulting annotation objects are shared by all attributes created from it.
+ */
+class VITRUVIO_API FAttributeSchema
+{
+public:
+	explicit FAttributeSchema(RuleFileInfoPtr RuleInfo);
+
+	const TArray<FRuleAttributeInfo>& GetAttributes() const
+	{
+		return Attributes;
+	}
+
+	const FRuleAttributeInfo* Find(const FString& Name) const;
+
+	/** Creates the (non hidden) attributes initialized with the given values. Has to be called on the game thread. */
+	TMap<FString, URuleAttribute*> CreateAttributes(const prt::AttributeMap& Values, UObject* Outer) const;
+
+	/**
+	 * Binds the shared annotations and attribute infos to attributes which have not been created from this schema, eg. attributes which
+	 * have been loaded with a level. Has to be called on the game thread.
+	 */
+	void BindAttributes(const TMap<FString, URuleAttribute*>& InAttributes) const;
+
+	void AddReferencedObjects(FReferenceCollector& Collector) const;
+
+private:
+	void CreateTemplates() const;
+
+	RuleFileInfoPtr RuleInfo;
+	TArray<FRuleAttributeInfo> Attributes;
+	TMap<FString, int32> AttributeIndices;
+
+	// Attributes with parsed annotations from which the attributes of the components are initialized (nullptr for hidden attributes)
+	mutable TArray<URuleAttribute*> Templates;
+	mutable bool bTemplatesCreated = false;
+};
+} // namespace Vitruvio
@@ -0,0 +1,59 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Interfaces/Interface_CollisionDataProvider.h"
+#include "UObject/Object.h"
+#include "VitruvioTypes.h"
+
+#include "GeneratedMeshCollisionDataProvider.generated.h"
+
+/**
+ * Provides the collision data of a static mesh shared through the static mesh registry to its body setup (which is created with this
+ * object as outer). It is owned by the static mesh and therefore lives as long as the mesh, independent of the components using it.
+ */
+UCLASS()
+class VITRUVIO_API UGeneratedMeshCollisionDataProvider : public UObject, public IInterface_CollisionDataProvider
+{
+	GENERATED_BODY()
+
+	virtual bool GetPhysicsTriMeshData(FTriMeshCollisionData* TriCollisionData, bool InUseAllTriData) override
+	{
+		if (!CollisionData || !CollisionData->IsValid())
+		{
+			return false;
+		}
+
+		TriCollisionData->Indices = CollisionData->Indices;
+		TriCollisionData->Vertices = CollisionData->Vertices;
+		TriCollisionData->bFlipNormals = true;
+		return true;
+	}
+
+	virtual bool ContainsPhysicsTriMeshData(bool InUseAllTriData) const override
+	{
+		return CollisionData && CollisionData->IsValid();
+	}
+
+public:
+	void SetCollisionData(const Vitruvio::FCollisionDataPtr& InCollisionData)
+	{
+		CollisionData = InCollisionData;
+	}
+
+private:
+	Vitruvio::FCollisionDataPtr CollisionData;
+};
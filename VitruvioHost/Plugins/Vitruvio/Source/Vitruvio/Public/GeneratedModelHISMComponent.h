@@ -28,28 +28,40 @@ class VITRUVIO_API UGeneratedModelHISMComponent : public UHierarchicalInstancedS
 
 	virtual bool GetPhysicsTriMeshData(FTriMeshCollisionData* TriCollisionData, bool InUseAllTriData) override
 	{
-		if (!CollisionData.IsValid())
+		if (!CollisionData || !CollisionData->IsValid())
 		{
 			return false;
 		}
 
-		TriCollisionData->Indices = CollisionData.Indices;
-		TriCollisionData->Vertices = CollisionData.Vertices;
+		TriCollisionData->Indices = CollisionData->Indices;
+		TriCollisionData->Vertices = CollisionData->Vertices;
 		TriCollisionData->bFlipNormals = true;
 		return true;
 	}
 
 	virtual bool ContainsPhysicsTriMeshData(bool InUseAllTriData) const override
 	{
-		return CollisionData.IsValid();
+		return CollisionData && CollisionData->IsValid();
 	}
 
 public:
-	void SetCollisionData(const Vitruvio::FCollisionData& InCollisionData)
+	void SetCollisionData(const Vitruvio::FCollisionDataPtr& InCollisionData)
 	{
 		CollisionData = InCollisionData;
 	}
 
+	/** Key of the instances (mesh and material overrides) this component holds, see Vitruvio::ComputeInstanceKey. */
+	const FSHAHash& GetInstanceKey() const
+	{
+		return InstanceKey;
+	}
+
+	void SetInstanceKey(const FSHAHash& InInstanceKey)
+	{
+		InstanceKey = InInstanceKey;
+	}
+
 private:
-	Vitruvio::FCollisionData CollisionData;
+	Vitruvio::FCollisionDataPtr CollisionData;
+	FSHAHash InstanceKey;
 };
\ No newline at end of file
@@ -28,28 +28,28 @@ class VITRUVIO_API UGeneratedModelStaticMeshComponent : public UStaticMeshCompon
 
 	virtual bool GetPhysicsTriMeshData(FTriMeshCollisionData* TriCollisionData, bool InUseAllTriData) override
 	{
-		if (!CollisionData.IsValid())
+		if (!CollisionData || !CollisionData->IsValid())
 		{
 			return false;
 		}
 
-		TriCollisionData->Indices = CollisionData.Indices;
-		TriCollisionData->Vertices = CollisionData.Vertices;
+		TriCollisionData->Indices = CollisionData->Indices;
+		TriCollisionData->Vertices = CollisionData->Vertices;
 		TriCollisionData->bFlipNormals = true;
 		return true;
 	}
 
 	virtual bool ContainsPhysicsTriMeshData(bool InUseAllTriData) const override
 	{
-		return CollisionData.IsValid();
+		return CollisionData && CollisionData->IsValid();
 	}
 
 public:
-	void SetCollisionData(const Vitruvio::FCollisionData& InCollisionData)
+	void SetCollisionData(const Vitruvio::FCollisionDataPtr& InCollisionData)
 	{
 		CollisionData = InCollisionData;
 	}
 
 private:
-	Vitruvio::FCollisionData CollisionData;
+	Vitruvio::FCollisionDataPtr CollisionData;
 };
\ No newline at end of file
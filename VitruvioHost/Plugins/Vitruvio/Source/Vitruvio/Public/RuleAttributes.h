@@ -131,6 +131,24 @@ public:
 		Annotation = InAnnotation;
 	}
 
+	UAttributeAnnotation* GetAnnotation() const
+	{
+		return Annotation;
+	}
+
+	/** Copies everything but the value (the annotation is shared). */
+	void CopyInfo(const URuleAttribute* FromAttribute)
+	{
+		Annotation = FromAttribute->Annotation;
+		Name = FromAttribute->Name;
+		DisplayName = FromAttribute->DisplayName;
+		Description = FromAttribute->Description;
+		Groups = FromAttribute->Groups;
+		Order = FromAttribute->Order;
+		GroupOrder = FromAttribute->GroupOrder;
+		Hidden = FromAttribute->Hidden;
+	}
+
 	virtual void CopyValue(const URuleAttribute* FromAttribute){};
 };
 
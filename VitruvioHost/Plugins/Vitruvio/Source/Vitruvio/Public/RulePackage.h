@@ -16,6 +16,9 @@
 #pragma once
 
 #include "Containers/Array.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/BulkData.h"
 #include "UObject/Object.h"
 
 #include "RulePackage.generated.h"
@@ -25,9 +28,6 @@ class VITRUVIO_API URulePackage final : public UObject
 {
 	GENERATED_BODY()
 public:
-	UPROPERTY(Transient)
-	TArray<uint8> Data;
-
 	void PreSave(const ITargetPlatform* TargetPlatform) override
 	{
 		Super::PreSave(TargetPlatform);
@@ -38,26 +38,39 @@ public:
 		FUniqueObjectGuid::GetOrCreateIDForObject(this);
 	}
 
-	virtual void Serialize(FArchive& Ar) override
-	{
-		Super::Serialize(Ar);
-
-		// We can not use TArray#BulkSerialize as it does not use the fast path if we are not cooking
-		// This is an adapted version of bulk serialize without that limitation
-		Data.CountBytes(Ar);
-		if (Ar.IsLoading())
-		{
-			int32 NewArrayNum = 0;
-			Ar << NewArrayNum;
-			Data.Empty(NewArrayNum);
-			Data.AddUninitialized(NewArrayNum);
-			Ar.Serialize(Data.GetData(), NewArrayNum);
-		}
-		else if (Ar.IsSaving())
-		{
-			int32 ArrayNum = Data.Num();
-			Ar << ArrayNum;
-			Ar.Serialize(Data.GetData(), ArrayNum);
-		}
-	}
+	void Serialize(FArchive& Ar) override;
+
+	void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
+	/**
+	 * Replaces the RPK content with the content of the given file. The file is read directly into the bulk data of this asset.
+	 *
+	 * \return whether the file could be read.
+	 */
+	bool ImportData(const FString& RpkPath);
+
+	/**
+	 * Writes the RPK content to the given file. If the content is not resident it is streamed from the package file with its own file handle,
+	 * the package linker is never accessed. Can therefore be called from any thread.
+	 *
+	 * \return whether the file could be written.
+	 */
+	bool SaveDataToFile(const FString& Path) const;
+
+	/** Returns the size of the RPK content in bytes, without loading it. */
+	int64 GetDataSize() const;
+
+	/**
+	 * Returns a hash of the RPK content which can be used to identify generated results independently of the asset path. The hash is
+	 * computed on import (or when an asset of the old format is loaded) and stored in the asset. Safe to query from any thread.
+	 */
+	FSHAHash GetContentHash() const;
+
+private:
+	// The RPK content. It is stored at the end of the package file and only streamed while it is written for unpacking.
+	mutable FByteBulkData Data;
+	mutable FCriticalSection DataLock;
+
+	mutable FCriticalSection ContentHashLock;
+	FSHAHash ContentHash;
 };
@@ -15,6 +15,8 @@
 
 #pragma once
 
+#include "GeneratedModelHISMComponent.h"
+#include "GeneratedModelStaticMeshComponent.h"
 #include "RuleAttributes.h"
 #include "RulePackage.h"
 #include "VitruvioModule.h"
@@ -25,19 +27,71 @@
 
 #include "VitruvioComponent.generated.h"
 
+namespace Vitruvio
+{
+class FApplyScheduler;
+class FAttributeMapBuilderCache;
+class FMaterialCache;
+class FTextureCache;
+}
+
 struct FInstance
 {
 	UStaticMesh* Mesh;
-	Vitruvio::FCollisionData CollisionData;
+	Vitruvio::FCollisionDataPtr CollisionData;
 	TArray<UMaterialInstanceDynamic*> OverrideMaterials;
 	TArray<FTransform> Transforms;
+	FSHAHash Key; // See Vitruvio::ComputeInstanceKey
 };
 
 struct FConvertedGenerateResult
 {
-	UStaticMesh* ShapeMesh;
-	Vitruvio::FCollisionData CollisionData;
+	UStaticMesh* ShapeMesh = nullptr;
+	Vitruvio::FCollisionDataPtr CollisionData;
 	TArray<FInstance> Instances;
+
+	// All meshes acquired from the static mesh registry and all override materials acquired from the material cache for this result, they
+	// have to be released once the result is not used anymore
+	TArray<UStaticMesh*> Meshes;
+	TArray<UMaterialInstanceDynamic*> Materials;
+};
+
+enum class EApplyStep : uint8
+{
+	LoadTextures,
+	BuildMeshes,
+	PrepareModel,
+	CreateInstances,
+	Finalize
+};
+
+enum class EApplyStepResult : uint8
+{
+	// The step has been applied, the next one can be applied right away
+	Continue,
+	// The step waits for asynchronous work (eg. texture loads), other components can be applied in the meantime
+	Waiting,
+	// The result has been applied completely
+	Finished
+};
+
+/** State of a generate result which is applied step by step by the apply scheduler. */
+struct FApplyState
+{
+	FGenerateResultDescription Result;
+	FConvertedGenerateResult ConvertedResult;
+	EApplyStep Step = EApplyStep::LoadTextures;
+
+	// Textures of the materials which are not cached yet, they are referenced until the materials have been created
+	TArray<FString> TexturePaths;
+	TArray<TSharedFuture<Vitruvio::FTextureData>> PendingTextures;
+	bool bTexturesRequested = false;
+
+	TWeakObjectPtr<UGeneratedModelStaticMeshComponent> ModelComponent;
+	int32 NextInstanceIndex = 0;
+
+	// Instance components of the previous result which have not (yet) been reused, they are destroyed when the result is finalized
+	TMultiMap<FSHAHash, TWeakObjectPtr<UGeneratedModelHISMComponent>> StaleInstanceComponents;
 };
 
 struct FLoadAttributes
@@ -64,6 +118,15 @@ class VITRUVIO_API UVitruvioComponent : public UActorComponent
 
 	bool bNotifyAttributeChange = false;
 
+	int32 AttributeUpdateDepth = 0;
+	bool bAttributeUpdatePending = false;
+
+	// Generate requests waiting to be dispatched according to the debounce settings in UVitruvioSettings
+	bool bGeneratePending = false;
+	double FirstPendingGenerateTime = 0;
+	double LastGenerateRequestTime = 0;
+	double LastGenerateStartTime = 0;
+
 public:
 	UVitruvioComponent();
 
@@ -93,6 +156,11 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Vitruvio", meta = (DisplayName = "Generate Collision Mesh"))
 	bool GenerateCollision = true;
 
+	/**
+	 * Requests a generate call. The call starts right away unless a generate call is still running or has started less than the minimum
+	 * generate interval ago. Such requests are coalesced and dispatched on a later tick, see the Generate Debounce settings of the
+	 * Vitruvio project settings.
+	 */
 	UFUNCTION(BlueprintCallable, Category = "Vitruvio")
 	void Generate();
 
@@ -171,6 +239,32 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Vitruvio")
 	bool GetFloatAttribute(const FString& Name, float& OutValue) const;
 
+	/**
+	 * Sets many attribute values at once and regenerates only once afterwards (if GenerateAutomatically is set to true).
+	 *
+	 * @param FloatValues The new values of float attributes by attribute name.
+	 * @param StringValues The new values of string attributes by attribute name.
+	 * @param BoolValues The new values of bool attributes by attribute name.
+	 * @returns true if all attributes have been set to the new values or false if at least one attribute does not exist or has another
+	 * type. In that case none of the values are set.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Vitruvio", meta = (AutoCreateRefTerm = "FloatValues,StringValues,BoolValues"))
+	bool SetAttributes(const TMap<FString, float>& FloatValues, const TMap<FString, FString>& StringValues, const TMap<FString, bool>& BoolValues);
+
+	/**
+	 * Starts an attribute update. Attribute setters called before the matching CommitAttributeUpdate do not trigger a regeneration.
+	 * Updates can be nested, only the outermost CommitAttributeUpdate regenerates.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Vitruvio")
+	void BeginAttributeUpdate();
+
+	/**
+	 * Ends an attribute update started with BeginAttributeUpdate.
+	 * If attributes have been set during the update and GenerateAutomatically is set to true this triggers exactly one regeneration.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Vitruvio")
+	void CommitAttributeUpdate();
+
 	/** Returns the attributes used for generation. */
 	UFUNCTION(BlueprintCallable, Category = "Vitruvio")
 	const TMap<FString, URuleAttribute*>& GetAttributes() const;
@@ -181,7 +275,8 @@ public:
 
 	/**
 	 * Sets the random seed used for generation.
-	 * If GenerateAutomatically is set to true this will automatically trigger a regeneration.
+	 * If GenerateAutomatically is set to true this will automatically trigger a regeneration (deferred until CommitAttributeUpdate inside
+	 * of an attribute update).
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Vitruvio")
 	void SetRandomSeed(int32 NewRandomSeed);
@@ -223,27 +318,62 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, DisplayName = "Random Seed", Category = "Vitruvio", meta = (AllowPrivateAccess = "true"))
 	int32 RandomSeed;
 
-	TQueue<FGenerateResultDescription> GenerateQueue;
+	TQueue<FGenerateResult::ResultType> GenerateQueue;
 	TQueue<FLoadAttributes> LoadAttributesQueue;
+	TQueue<TSharedPtr<const Vitruvio::FAttributeSchema>> AttributeSchemaQueue;
+
+	// The schema the attributes have been created from or bound to, shared with all components using the same rule package
+	TSharedPtr<const Vitruvio::FAttributeSchema> AttributeSchema;
+
+	// Keeps the PRT attribute map of the previous generate call so that only changed attributes have to be converted again
+	TSharedPtr<Vitruvio::FAttributeMapBuilderCache> AttributeMapBuilderCache;
+
+	TUniquePtr<FApplyState> ApplyState;
+
+	// Meshes and materials of the applied result acquired from the static mesh registry and the material cache (which keep them alive)
+	TArray<UStaticMesh*> AppliedMeshes;
+	TArray<UMaterialInstanceDynamic*> AppliedMaterials;
 
 	FGenerateResult::FTokenPtr GenerateToken;
 	FAttributeMapResult::FTokenPtr LoadAttributesInvalidationToken;
+	FAttributeMapResult::FTokenPtr LoadAttributeSchemaInvalidationToken;
 
 	bool HasGeneratedMesh = false;
 
 	void CalculateRandomSeed();
 
 	void LoadDefaultAttributes(bool KeepOldAttributeValues = false, bool ForceRegenerate = false);
+	void LoadAttributeSchema();
+	void ResetAttributeSchema();
 	void NotifyAttributesChanged();
+	void OnAttributeValuesChanged();
 
 	void RemoveGeneratedMeshes();
 
 	void ProcessGenerateQueue();
 	void ProcessLoadAttributesQueue();
-
-	FConvertedGenerateResult BuildResult(FGenerateResultDescription& GenerateResult,
-										 TMap<Vitruvio::FMaterialAttributeContainer, UMaterialInstanceDynamic*>& MaterialCache,
-										 TMap<FString, Vitruvio::FTextureData>& TextureCache);
+	void ProcessAttributeSchemaQueue();
+	void ProcessPendingGenerate();
+	void StartGenerate();
+
+	friend class Vitruvio::FApplyScheduler;
+
+	/** Applies the next step of the current generate result. Never blocks, steps which wait for asynchronous work return Waiting. */
+	EApplyStepResult ApplyNextStep();
+	FVector GetApplyLocation() const;
+	void ResetApplyState();
+	void ReleaseApplyTextures();
+	void ReleaseAppliedResources();
+
+	UGeneratedModelStaticMeshComponent* FindModelComponent() const;
+	UGeneratedModelStaticMeshComponent* PrepareModelComponent(
+		const FConvertedGenerateResult& ConvertedResult, TMultiMap<FSHAHash, TWeakObjectPtr<UGeneratedModelHISMComponent>>& OutInstanceComponents);
+	void CreateInstanceComponent(UGeneratedModelStaticMeshComponent* VitruvioModelComponent, const FInstance& Instance);
+	void UpdateInstanceComponent(UGeneratedModelHISMComponent* InstancedComponent, const FInstance& Instance);
+
+	FConvertedGenerateResult BuildResult(const FGenerateResultDescription& GenerateResult,
+										 Vitruvio::FMaterialCache& MaterialCache,
+										 Vitruvio::FTextureCache& TextureCache);
 
 #if WITH_EDITOR
 	FDelegateHandle PropertyChangeDelegate;
@@ -35,11 +35,34 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogUnrealPrt, Log, All);
 
+class UVitruvioComponent;
+
+namespace Vitruvio
+{
+class FApplyScheduler;
+class FGenerateThreadPool;
+class FGenerateResultCache;
+class FGenerateResultDiskCache;
+class FMaterialCache;
+class FRpkUnpackCache;
+struct FRulePackageContext;
+class FStaticMeshRegistry;
+class FTextureCache;
+}
+
 struct FGenerateResultDescription
 {
 	Vitruvio::FInstanceMap Instances;
-	TMap<int32, FMeshDescription> MeshDescriptions;
-	TMap<int32, TArray<Vitruvio::FMaterialAttributeContainer>> Materials;
+	// Generated meshes by prototype id (UnrealCallbacks::NO_PROTOTYPE_INDEX for the non instanced geometry)
+	TMap<int32, Vitruvio::FGeneratedMeshPtr> Meshes;
+};
+
+struct FGenerateRequest
+{
+	TArray<FInitialShapeFace> InitialShape;
+	URulePackage* RulePackage = nullptr;
+	AttributeMapUPtr Attributes;
+	int32 RandomSeed = 0;
 };
 
 class FInvalidationToken
@@ -75,6 +98,15 @@ public:
 		return bRequestRegenerate;
 	}
 
+	/**
+	 * \brief A generate call is canceled if its result has been invalidated or superseded by a regenerate request. Ongoing generate calls
+	 * poll this and abort as soon as possible.
+	 */
+	bool IsCanceled() const
+	{
+		return IsInvalid() || IsRegenerateRequested();
+	}
+
 private:
 	FThreadSafeBool bRequestRegenerate = false;
 };
@@ -98,11 +130,15 @@ public:
 };
 
 using FGenerateResult = TResult<FGenerateResultDescription, FGenerateToken>;
+using FBatchGenerateResult = TResult<TArray<FGenerateResultDescription>, FGenerateToken>;
 using FAttributeMapResult = TResult<FAttributeMapPtr, FInvalidationToken>;
 
 class VitruvioModule final : public IModuleInterface, public FGCObject
 {
 public:
+	VitruvioModule();
+	~VitruvioModule() override;
+
 	void StartupModule() override;
 	void ShutdownModule() override;
 
@@ -116,11 +152,13 @@ public:
 	 * \param RulePackage
 	 * \param Attributes
 	 * \param RandomSeed
+	 * \param Priority the priority of the generate call in the generate queue
 	 * \return the generated UStaticMesh.
 	 */
 	VITRUVIO_API FGenerateResult GenerateAsync(const TArray<FInitialShapeFace>& InitialShape, UMaterial* OpaqueParent, UMaterial* MaskedParent,
 											   UMaterial* TranslucentParent, URulePackage* RulePackage, AttributeMapUPtr Attributes,
-											   const int32 RandomSeed) const;
+											   const int32 RandomSeed,
+											   Vitruvio::EGeneratePriority Priority = Vitruvio::EGeneratePriority::Normal) const;
 
 	/**
 	 * \brief Generate the models with the given InitialShape, RulePackage and Attributes.
@@ -139,7 +177,26 @@ public:
 													 const int32 RandomSeed) const;
 
 	/**
-	 * \brief Asynchronously loads the default attribute values for the given initial shape and rule package
+	 * \brief Asynchronously generate the models for all given requests using a single PRT generate call.
+	 *
+	 * \param Requests the initial shapes, rule packages, attributes and random seeds to generate
+	 * \param Priority the priority of the generate call in the generate queue
+	 * \return the generated results in the same order as the given requests.
+	 */
+	VITRUVIO_API FBatchGenerateResult GenerateBatchAsync(TArray<FGenerateRequest> Requests,
+														 Vitruvio::EGeneratePriority Priority = Vitruvio::EGeneratePriority::Normal) const;
+
+	/**
+	 * \brief Generate the models for all given requests using a single PRT generate call.
+	 *
+	 * \param Requests the initial shapes, rule packages, attributes and random seeds to generate
+	 * \return the generated results in the same order as the given requests.
+	 */
+	VITRUVIO_API TArray<FGenerateResultDescription> GenerateBatch(TArray<FGenerateRequest> Requests) const;
+
+	/**
+	 * \brief Asynchronously loads the default attribute values for the given initial shape and rule package. Requests are gathered over
+	 * a short time window (see UVitruvioSettings::AttributeBatchWindowMs) and evaluated together in a single generate call.
 	 *
 	 * \param InitialShape
 	 * \param RulePackage
@@ -149,6 +206,15 @@ public:
 	VITRUVIO_API FAttributeMapResult LoadDefaultRuleAttributesAsync(const TArray<FInitialShapeFace>& InitialShape, URulePackage* RulePackage,
 																	const int32 RandomSeed) const;
 
+	/**
+	 * \brief Asynchronously loads the attribute schema of the given rule package without evaluating any attribute values. The schema is
+	 * shared by all components using the rule package.
+	 *
+	 * \param RulePackage
+	 * \return the schema or nullptr if the rule package could not be loaded.
+	 */
+	VITRUVIO_API TFuture<TSharedPtr<const Vitruvio::FAttributeSchema>> LoadAttributeSchemaAsync(URulePackage* RulePackage) const;
+
 	/**
 	 * \return whether PRT is initialized meaning installed and ready to use. Before initialization generation is not possible and will
 	 * immediately return without results.
@@ -174,6 +240,29 @@ public:
 		return GenerateCallsCounter.GetValue();
 	}
 
+	/**
+	 * \return statistics (queue depth, wait times) of the worker threads used for generate and attribute loading calls.
+	 */
+	VITRUVIO_API Vitruvio::FGenerateQueueStats GetGenerateQueueStats() const;
+
+	/**
+	 * \return statistics (size, hits, misses) of the cache for generated models.
+	 */
+	VITRUVIO_API Vitruvio::FGenerateCacheStats GetGenerateCacheStats() const;
+
+	/**
+	 * \brief Removes all generated models from the in-memory and the on-disk cache.
+	 */
+	VITRUVIO_API void ClearGenerateCache() const;
+
+	/**
+	 * \brief Schedules the pending generate result of the given component to be applied on the game thread. Results are applied in steps
+	 * which are spread over multiple frames according to the configured per-frame budget. Components closer to the camera are applied first.
+	 *
+	 * \param Component the component which has a pending generate result.
+	 */
+	VITRUVIO_API void ScheduleApply(UVitruvioComponent* Component) const;
+
 	/**
 	 * \return true if currently at least one RPK is being loaded.
 	 */
@@ -185,23 +274,38 @@ public:
 	/**
 	 * \returns the cache used for materials generated by PRT.
 	 */
-	VITRUVIO_API TMap<Vitruvio::FMaterialAttributeContainer, UMaterialInstanceDynamic*>& GetMaterialCache()
+	VITRUVIO_API Vitruvio::FMaterialCache& GetMaterialCache() const
 	{
-		return MaterialCache;
+		return *MaterialCache;
 	}
 
 	/**
-	 * \returns the cache used for materials generated by PRT.
+	 * \return statistics (live and unused materials, hit rate, memory) of the cache used for materials generated by PRT.
+	 */
+	VITRUVIO_API Vitruvio::FMaterialCacheStats GetMaterialCacheStats() const;
+
+	/**
+	 * \returns the cache used for textures of materials generated by PRT.
 	 */
-	VITRUVIO_API TMap<FString, Vitruvio::FTextureData>& GetTextureCache()
+	VITRUVIO_API Vitruvio::FTextureCache& GetTextureCache() const
 	{
-		return TextureCache;
+		return *TextureCache;
 	}
 
-	void AddReferencedObjects(FReferenceCollector& Collector) override
+	/**
+	 * \return statistics (size, loads in flight, hits, misses) of the cache used for textures of materials generated by PRT.
+	 */
+	VITRUVIO_API Vitruvio::FTextureCacheStats GetTextureCacheStats() const;
+
+	/**
+	 * \returns the registry of static meshes shared between all Vitruvio components.
+	 */
+	VITRUVIO_API Vitruvio::FStaticMeshRegistry& GetStaticMeshRegistry() const
 	{
-		Collector.AddReferencedObjects(MaterialCache);
-	};
+		return *StaticMeshRegistry;
+	}
+
+	void AddReferencedObjects(FReferenceCollector& Collector) override;
 
 	static VitruvioModule& Get()
 	{
@@ -215,9 +319,20 @@ private:
 
 	UnrealLogHandler* LogHandler = nullptr;
 
+	TUniquePtr<Vitruvio::FGenerateThreadPool> GenerateThreadPool;
+	TUniquePtr<Vitruvio::FGenerateResultCache> GenerateResultCache;
+	TUniquePtr<Vitruvio::FGenerateResultDiskCache> GenerateResultDiskCache;
+	TUniquePtr<Vitruvio::FApplyScheduler> ApplyScheduler;
+	TUniquePtr<Vitruvio::FStaticMeshRegistry> StaticMeshRegistry;
+
 	TAtomic<bool> Initialized = false;
 
-	mutable TMap<TLazyObjectPtr<URulePackage>, ResolveMapSPtr> ResolveMapCache;
+	// Encoder options do not depend on the rule package and are only created once
+	AttributeMapUPtr UnrealEncoderOptions;
+	AttributeMapUPtr AttributeEvalEncoderOptions;
+
+	// Contexts of rule packages which failed to load are cached as nullptr
+	mutable TMap<TLazyObjectPtr<URulePackage>, TSharedPtr<const Vitruvio::FRulePackageContext>> RulePackageContextCache;
 	mutable TMap<TLazyObjectPtr<URulePackage>, FGraphEventRef> ResolveMapEventGraphRefCache;
 
 	mutable FCriticalSection LoadResolveMapLock;
@@ -226,11 +341,21 @@ private:
 	mutable FThreadSafeCounter RpkLoadingTasksCounter;
 	mutable FThreadSafeCounter LoadAttributesCounter;
 
-	FString RpkFolder;
+	TUniquePtr<Vitruvio::FRpkUnpackCache> RpkUnpackCache;
+
+	TUniquePtr<Vitruvio::FTextureCache> TextureCache;
+	TUniquePtr<Vitruvio::FMaterialCache> MaterialCache;
 
-	TMap<Vitruvio::FMaterialAttributeContainer, UMaterialInstanceDynamic*> MaterialCache;
-	TMap<FString, Vitruvio::FTextureData> TextureCache;
+	// Requests for default attribute values waiting to be evaluated together (see LoadDefaultRuleAttributesAsync)
+	struct FPendingAttributeRequest;
+	mutable FCriticalSection PendingAttributeRequestsLock;
+	mutable TArray<TSharedPtr<FPendingAttributeRequest>> PendingAttributeRequests;
+	mutable FDelegateHandle AttributeBatchTickerHandle;
 
-	TFuture<ResolveMapSPtr> LoadResolveMapAsync(URulePackage* RulePackage) const;
+	TFuture<TSharedPtr<const Vitruvio::FRulePackageContext>> LoadRulePackageContextAsync(URulePackage* RulePackage) const;
+	TArray<FGenerateResultDescription> GenerateBatchInternal(TArray<FGenerateRequest> Requests, const FGenerateToken* CancelToken) const;
+	void PrefetchTextures(const TArray<FGenerateResultDescription>& Results) const;
+	void FlushAttributeRequests() const;
+	void EvaluateDefaultAttributes(const TArray<TSharedPtr<FPendingAttributeRequest>>& Requests) const;
 	void InitializePrt();
 };
@@ -0,0 +1,106 @@
+/* Copyright 2021 Esri
+ *
+ * Licensed under the Apache License Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+
+#include "VitruvioSettings.generated.h"
+
+UCLASS(config = Engine, defaultconfig, meta = (DisplayName = "Vitruvio"))
+class VITRUVIO_API UVitruvioSettings final : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UVitruvioSettings();
+
+	/** Number of worker threads used for generate and attribute loading calls. If set to 0 the number of physical cores minus one is used. */
+	UPROPERTY(config, EditAnywhere, Category = "Generation", meta = (ClampMin = 0, UIMin = 0, ConfigRestartRequired = true))
+	int32 NumGenerateThreads = 0;
+
+	/**
+	 * Memory budget in megabytes for caching generated models. Generate calls with identical initial shape, attributes, random seed and
+	 * rule package are served from the cache. Set to 0 to disable the cache.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = "Generation", meta = (ClampMin = 0, UIMin = 0, ConfigRestartRequired = true))
+	int32 GenerateCacheSizeMB = 512;
+
+	/** Whether generated models are additionally stored in Saved/Vitruvio so that they do not need to be regenerated in later sessions. */
+	UPROPERTY(config, EditAnywhere, Category = "Generation", meta = (ConfigRestartRequired = true))
+	bool bEnableDiskCache = true;
+
+	/** Disk budget in megabytes for generated models stored in Saved/Vitruvio. The least recently used models are deleted once it is exceeded. */
+	UPROPERTY(config, EditAnywhere, Category = "Generation",
+			  meta = (ClampMin = 0, UIMin = 0, ConfigRestartRequired = true, EditCondition = "bEnableDiskCache"))
+	int32 DiskCacheSizeMB = 2048;
+
+	/**
+	 * Time in milliseconds which may be spent per frame on applying generate results (building meshes and creating components) on the
+	 * game thread. Results which do not fit into the budget are applied in the following frames, closest to the camera first.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = "Generation", meta = (ClampMin = 0, UIMin = 0, ConfigRestartRequired = true))
+	float ApplyBudgetMs = 5.0f;
+
+	/**
+	 * Number of materials which are kept in the material cache after they are no longer used by any generated model. Kept materials are
+	 * reused if a later generate result needs the same material.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = "Generation", meta = (ClampMin = 0, UIMin = 0, ConfigRestartRequired = true))
+	int32 MaxUnusedMaterials = 256;
+
+	/**
+	 * Memory budget in megabytes for textures loaded for generated materials. Textures which are not used by any cached material anymore
+	 * are evicted once the budget is exceeded.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = "Generation", meta = (ClampMin = 0, UIMin = 0, ConfigRestartRequired = true))
+	int32 TextureCacheSizeMB = 1024;
+
+	/**
+	 * Disk budget in megabytes for unpacked rule packages, which are kept in Saved/Vitruvio/RpkCache across sessions. The least recently
+	 * used rule packages are deleted once the budget is exceeded.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = "Generation", meta = (ClampMin = 0, UIMin = 0, ConfigRestartRequired = true))
+	int32 RpkCacheSizeMB = 4096;
+
+	/**
+	 * Time window in milliseconds over which requests for default attribute values are gathered and evaluated in a single generate call,
+	 * eg. for all components of a level which has just been loaded. 0 evaluates every request on its own.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = "Generation", meta = (ClampMin = 0, UIMin = 0))
+	float AttributeBatchWindowMs = 20.0f;
+
+	/**
+	 * Time in milliseconds a component waits for further generate requests (eg. attribute changes) before it generates. Rapid requests are
+	 * coalesced into one generate call on the trailing edge of this window. 0 generates on the first request.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = "Generate Debounce", meta = (ClampMin = 0, UIMin = 0))
+	float GenerateDebounceMs = 50.0f;
+
+	/**
+	 * Maximum time in milliseconds a generate request is delayed while further requests keep coming (eg. during a slider drag), so that
+	 * intermediate results are shown. 0 waits until the requests have settled.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = "Generate Debounce", meta = (ClampMin = 0, UIMin = 0))
+	float MaxGenerateDelayMs = 250.0f;
+
+	/** Minimum time in milliseconds between the start of two generate calls of the same component. */
+	UPROPERTY(config, EditAnywhere, Category = "Generate Debounce", meta = (ClampMin = 0, UIMin = 0))
+	float MinGenerateIntervalMs = 100.0f;
+
+	/** Returns the number of worker threads which should be used for generate calls. */
+	int32 GetNumGenerateThreads() const;
+};
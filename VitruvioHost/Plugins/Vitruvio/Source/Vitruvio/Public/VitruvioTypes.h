@@ -17,6 +17,8 @@
 
 #include "CoreUObject.h"
 #include "Materials/MaterialInstanceDynamic.h"
+#include "MeshDescription.h"
+#include "Misc/SecureHash.h"
 #include "PhysicsCore/Public/Interface_CollisionDataProviderCore.h"
 
 #include "prt/AttributeMap.h"
@@ -24,6 +26,59 @@
 namespace Vitruvio
 {
 
+enum class EGeneratePriority : uint8
+{
+	High,
+	Normal,
+	Low,
+
+	Num
+};
+
+struct FGenerateQueueStats
+{
+	int32 NumThreads = 0;
+	int32 QueueDepth = 0;
+	int32 ActiveJobs = 0;
+	uint64 CompletedJobs = 0;
+
+	/** Average and maximum time in seconds a job has been waiting in the queue before it has been started. */
+	double AverageWaitTime = 0;
+	double MaxWaitTime = 0;
+};
+
+struct FGenerateCacheStats
+{
+	int32 NumEntries = 0;
+	int64 SizeBytes = 0;
+	int64 BudgetBytes = 0;
+	uint64 Hits = 0;
+	uint64 Misses = 0;
+	uint64 Evictions = 0;
+};
+
+struct FMaterialCacheStats
+{
+	int32 NumMaterials = 0;
+	int32 NumUnused = 0;
+	int32 MaxUnused = 0;
+	int64 SizeBytes = 0;
+	uint64 Hits = 0;
+	uint64 Misses = 0;
+	uint64 Evictions = 0;
+};
+
+struct FTextureCacheStats
+{
+	int32 NumTextures = 0;
+	int32 NumLoading = 0;
+	int64 SizeBytes = 0;
+	int64 BudgetBytes = 0;
+	uint64 Hits = 0;
+	uint64 Misses = 0;
+	uint64 Evictions = 0;
+};
+
 struct FCollisionData
 {
 	TArray<FTriIndices> Indices;
@@ -34,6 +89,10 @@ struct FCollisionData
 		return Indices.Num() > 0 && Vertices.Num() > 0;
 	}
 };
+using FCollisionDataPtr = TSharedPtr<const FCollisionData, ESPMode::ThreadSafe>;
+
+/** Creates the collision data (vertices and triangles) of the given mesh. The mesh has to be triangulated. */
+FCollisionData CreateCollisionData(const FMeshDescription& MeshDescription);
 
 struct FMaterialAttributeContainer
 {
@@ -45,8 +104,20 @@ struct FMaterialAttributeContainer
 	FString BlendMode;
 	FString Name; // ignored on purpose for hash and equality
 
+	FMaterialAttributeContainer() = default;
 	explicit FMaterialAttributeContainer(const prt::AttributeMap* AttributeMap);
 
+	friend FArchive& operator<<(FArchive& Ar, FMaterialAttributeContainer& Container)
+	{
+		Ar << Container.TextureProperties;
+		Ar << Container.ColorProperties;
+		Ar << Container.ScalarProperties;
+		Ar << Container.StringProperties;
+		Ar << Container.BlendMode;
+		Ar << Container.Name;
+		return Ar;
+	}
+
 	friend bool operator==(const FMaterialAttributeContainer& Lhs, const FMaterialAttributeContainer& RHS)
 	{
 		// clang-format off
@@ -73,6 +144,13 @@ struct FInstanceCacheKey
 
 	friend uint32 GetTypeHash(const FInstanceCacheKey& Object);
 
+	friend FArchive& operator<<(FArchive& Ar, FInstanceCacheKey& Key)
+	{
+		Ar << Key.PrototypeId;
+		Ar << Key.MaterialOverrides;
+		return Ar;
+	}
+
 	friend bool operator==(const FInstanceCacheKey& Lhs, const FInstanceCacheKey& RHS)
 	{
 		return Lhs.PrototypeId == RHS.PrototypeId && Lhs.MaterialOverrides == RHS.MaterialOverrides;
@@ -85,13 +163,49 @@ struct FInstanceCacheKey
 };
 using FInstanceMap = TMap<FInstanceCacheKey, TArray<FTransform>>;
 
+/**
+ * A single mesh generated by PRT. Generated meshes are immutable once created and shared (instead of copied) between the generate
+ * result caches, generate results and the components which build static meshes from them.
+ */
+struct FGeneratedMesh
+{
+	FMeshDescription MeshDescription;
+
+	// One material per polygon group (in polygon group order). The material slot names of the polygon groups are unique.
+	TArray<FMaterialAttributeContainer> Materials;
+
+	FCollisionDataPtr CollisionData;
+
+	// Hash of the geometry and the materials, identical meshes of different generate results have the same content hash
+	FSHAHash ContentHash;
+};
+using FGeneratedMeshPtr = TSharedPtr<const FGeneratedMesh, ESPMode::ThreadSafe>;
+
+/** Computes the content hash of a generated mesh. The material names are ignored (like for material equality). */
+FSHAHash ComputeMeshContentHash(const FMeshDescription& MeshDescription, const TArray<FMaterialAttributeContainer>& Materials);
+
+/** Computes a key which identifies instances of the mesh with the given content hash and material overrides. */
+FSHAHash ComputeInstanceKey(const FSHAHash& MeshContentHash, const TArray<FMaterialAttributeContainer>& MaterialOverrides);
+
+/** Classification of the content of an opacity map, determines the blend mode of materials using it. */
+enum class EOpacityMapClass : uint8
+{
+	// Not classified (eg. 16 bit textures)
+	Unknown,
+	// (Almost) all pixels are white
+	Opaque,
+	// (Almost) all pixels are either black or white
+	Masked,
+	Blend
+};
+
 struct FTextureData
 {
 	FTextureData() = default;
 
 	UTexture2D* Texture = nullptr;
 	uint32 NumChannels = 0; // The real amount of channels. See MaterialConversion#LoadTextureFromDisk
-	FDateTime LoadTime;
+	EOpacityMapClass OpacityClass = EOpacityMapClass::Unknown; // Computed when loading textures. See OpacityMapClassification.h
 
 	friend bool operator==(const FTextureData& Lhs, const FTextureData& Rhs)
 	{
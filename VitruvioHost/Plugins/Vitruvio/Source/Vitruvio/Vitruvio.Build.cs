@@ -39,6 +39,7 @@ public class Vitruvio : ModuleRules
 				"PhysicsCore",
 				"RenderCore",
 				"Projects",
+				"DeveloperSettings",
 				"SlateCore",
 				"Slate",
 				"AppFramework",
@@ -27,16 +27,17 @@ URulePackageFactory::URulePackageFactory(const FObjectInitializer& ObjectInitial
 	Formats.Add("rpk;Esri Rule Package");
 }
 
-// TODO: do we want to load the whole RPK into memory? Alternatively use FactoryCreateFile() and just keep the filename?
-UObject* URulePackageFactory::FactoryCreateBinary(UClass* Class, UObject* InParent, FName Name, EObjectFlags Flags, UObject* Context,
-												  const TCHAR* Type, const uint8*& Buffer, const uint8* BufferEnd, FFeedbackContext* Warn)
+UObject* URulePackageFactory::FactoryCreateFile(UClass* Class, UObject* InParent, FName Name, EObjectFlags Flags, const FString& Filename,
+												const TCHAR* Parms, FFeedbackContext* Warn, bool& bOutOperationCanceled)
 {
 	URulePackage* RulePackage = NewObject<URulePackage>(InParent, SupportedClass, Name, Flags | RF_Transactional);
 
-	const SIZE_T DataSize = BufferEnd - Buffer;
-	RulePackage->Data.Reset(DataSize);
-	RulePackage->Data.AddUninitialized(DataSize);
-	FMemory::Memcpy(RulePackage->Data.GetData(), Buffer, DataSize);
+	// Read the file directly into the bulk data of the asset instead of buffering it first
+	if (!RulePackage->ImportData(Filename))
+	{
+		Warn->Logf(ELogVerbosity::Error, TEXT("Could not read rule package %s"), *Filename);
+		return nullptr;
+	}
 
 	return RulePackage;
 }
@@ -24,8 +24,8 @@ class URulePackageFactory final : public UFactory
 {
 	GENERATED_UCLASS_BODY()
 
-	UObject* FactoryCreateBinary(UClass* Class, UObject* InParent, FName Name, EObjectFlags Flags, UObject* Context, const TCHAR* Type,
-								 const uint8*& Buffer, const uint8* BufferEnd, FFeedbackContext* Warn) override;
+	UObject* FactoryCreateFile(UClass* Class, UObject* InParent, FName Name, EObjectFlags Flags, const FString& Filename, const TCHAR* Parms,
+							   FFeedbackContext* Warn, bool& bOutOperationCanceled) override;
 
 	bool FactoryCanImport(const FString& Filename) override;
 